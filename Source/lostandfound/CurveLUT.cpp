@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CurveLUT.h"
+#include "Curves/CurveFloat.h"
+
+void FCurveLUT::bake(UCurveFloat const * curve, float defaultValue)
+{
+	mHasCurve = curve != nullptr;
+
+	float minTime = 0.0f;
+	float maxTime = 0.0f;
+	if (curve) {
+		curve->GetTimeRange(minTime, maxTime);
+	}
+
+	float const range = maxTime - minTime;
+	mStartTime = minTime;
+	mInvStep = range > KINDA_SMALL_NUMBER ? (NumSamples - 1) / range : 0.0f;
+
+	for (int32 i = 0; i < NumSamples; i++) {
+		mSamples[i] = curve ? curve->GetFloatValue(minTime + range * i / (NumSamples - 1)) : defaultValue;
+	}
+}
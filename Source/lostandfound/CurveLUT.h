@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UCurveFloat;
+
+/*
+ * Fixed size lookup table baked from a UCurveFloat over the time range of the curve.
+ * Sampling is a clamp and a linear interpolation between two samples, no rich curve key search per tick.
+ */
+struct LOSTANDFOUND_API FCurveLUT
+{
+	static constexpr int32 NumSamples = 32;
+
+	FCurveLUT() { bake(nullptr); }
+
+	/* Without a curve every sample is defaultValue. */
+	void bake(UCurveFloat const * curve, float defaultValue = 1.0f);
+
+	FORCEINLINE float sample(float time) const
+	{
+		float const position = FMath::Clamp((time - mStartTime) * mInvStep, 0.0f, float(NumSamples - 1));
+		int32 const index = FMath::Min((int32)position, NumSamples - 2);
+		return FMath::Lerp(mSamples[index], mSamples[index + 1], position - index);
+	}
+
+	/* A curve was baked, not only the default value. */
+	FORCEINLINE bool hasCurve() const { return mHasCurve; }
+
+private:
+	float mSamples[NumSamples];
+	float mStartTime = 0.0f;
+	float mInvStep = 0.0f;
+	bool mHasCurve = false;
+};
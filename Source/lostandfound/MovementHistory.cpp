@@ -0,0 +1,161 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "MovementHistory.h"
+#include "GameFramework/Character.h"
+#include "Components/CapsuleComponent.h"
+
+void FMovementHistory::reset()
+{
+	mWriteCount.store(0, std::memory_order_release);
+}
+
+void FMovementHistory::push(FMovementSnapshot const & snapshot)
+{
+	uint32 const count = mWriteCount.load(std::memory_order_relaxed);
+	// pairs with the fence in rewind, the previous count is visible before any part of the overwritten slot
+	std::atomic_thread_fence(std::memory_order_release);
+	mSamples[count % Capacity] = snapshot;
+	mWriteCount.store(count + 1, std::memory_order_release);
+}
+
+double FMovementHistory::getOldestTime() const
+{
+	uint32 const count = mWriteCount.load(std::memory_order_acquire);
+	if (count == 0) {
+		return 0.0;
+	}
+	return mSamples[(count > Capacity ? count - Capacity + 1 : 0) % Capacity].time;
+}
+
+bool FMovementHistory::rewind(double time, FMovementSnapshot& out) const
+{
+	uint32 const count = mWriteCount.load(std::memory_order_acquire);
+	if (count == 0) {
+		return false;
+	}
+
+	// keep one slot distance to the writer, it might be overwriting the oldest sample right now
+	uint32 low = count > Capacity ? count - Capacity + 1 : 0;
+	uint32 high = count - 1;
+
+	if (time < mSamples[low % Capacity].time || time > mSamples[high % Capacity].time) {
+		return false;
+	}
+
+	// samples are ordered by time, binary search the pair around time
+	while (high - low > 1) {
+		uint32 const mid = low + (high - low) / 2;
+		if (mSamples[mid % Capacity].time <= time) {
+			low = mid;
+		}
+		else {
+			high = mid;
+		}
+	}
+
+	FMovementSnapshot const a = mSamples[low % Capacity];
+	FMovementSnapshot const b = mSamples[high % Capacity];
+
+	// the writer lapped the samples that were read. An acquire load does not order the sample reads above,
+	// the fence keeps them from moving past the count check
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (mWriteCount.load(std::memory_order_relaxed) - low >= Capacity) {
+		return false;
+	}
+
+	float const alpha = b.time > a.time ? (float)((time - a.time) / (b.time - a.time)) : 0.0f;
+	FMovementSnapshot const & nearest = alpha < 0.5f ? a : b;
+
+	out = nearest;
+	out.time = time;
+	out.location = FMath::Lerp(a.location, b.location, alpha);
+	out.capsuleRadius = FMath::Lerp(a.capsuleRadius, b.capsuleRadius, alpha);
+	out.capsuleHalfHeight = FMath::Lerp(a.capsuleHalfHeight, b.capsuleHalfHeight, alpha);
+	return true;
+}
+
+UMovementHistoryComponent::UMovementHistoryComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	// record the final position of the frame
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+}
+
+void UMovementHistoryComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	owner = Cast<ACharacter>(GetOwner());
+	specialMoves = GetOwner()->FindComponentByClass<USpecialMovementComponent>();
+
+	mHistory.reset();
+	// only the server rewinds
+	SetComponentTickEnabled(owner && owner->HasAuthority() && GetNetMode() != NM_Standalone);
+}
+
+void UMovementHistoryComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	UCapsuleComponent const* capsule = owner->GetCapsuleComponent();
+
+	FMovementSnapshot snapshot;
+	snapshot.time = GetWorld()->GetTimeSeconds();
+	snapshot.location = FVector3f(owner->GetActorLocation());
+	snapshot.capsuleRadius = capsule->GetScaledCapsuleRadius();
+	snapshot.capsuleHalfHeight = capsule->GetScaledCapsuleHalfHeight();
+	snapshot.state = specialMoves ? specialMoves->mState : ESpecialMovementState::NONE;
+
+	FVector const wallNormal = specialMoves ? specialMoves->getWallNormal() : FVector::ZeroVector;
+	for (int32 i = 0; i < 3; i++) {
+		snapshot.wallNormal[i] = (int8)FMath::Clamp(FMath::RoundToInt(wallNormal[i] * 127.0f), -127, 127);
+	}
+
+	mHistory.push(snapshot);
+}
+
+bool UMovementHistoryComponent::rewind(double serverTime, FMovementSnapshot& outSnapshot) const
+{
+	return mHistory.rewind(serverTime, outSnapshot);
+}
+
+bool UMovementHistoryComponent::rewindLineTest(double serverTime, FVector const & start, FVector const & end, FVector* outHitLocation) const
+{
+	FMovementSnapshot snapshot;
+	if (rewind(serverTime, snapshot) == false) {
+		return false;
+	}
+
+	// capsule = segment between the centers of the two hemispheres, inflated by the radius
+	FVector const center(snapshot.location);
+	FVector const axis(0.0f, 0.0f, FMath::Max(snapshot.capsuleHalfHeight - snapshot.capsuleRadius, 0.0f));
+
+	FVector onLine, onAxis;
+	FMath::SegmentDistToSegmentSafe(start, end, center - axis, center + axis, onLine, onAxis);
+	if (FVector::DistSquared(onLine, onAxis) > FMath::Square(snapshot.capsuleRadius)) {
+		return false;
+	}
+
+	if (outHitLocation) {
+		*outHitLocation = onLine;
+	}
+	return true;
+}
+
+bool UMovementHistoryComponent::rewindLocation(float serverTime, FVector& location, ESpecialMovementState& state) const
+{
+	FMovementSnapshot snapshot;
+	if (rewind(serverTime, snapshot) == false) {
+		return false;
+	}
+
+	location = FVector(snapshot.location);
+	state = snapshot.state;
+	return true;
+}
+
+void UMovementHistoryComponent::resetHistory()
+{
+	mHistory.reset();
+}
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "SpecialMovementComponent.h"
+#include <atomic>
+#include "MovementHistory.generated.h"
+
+/* Compact movement state of a character at one server time. */
+struct FMovementSnapshot
+{
+	double time;
+	FVector3f location;
+	float capsuleRadius;
+	float capsuleHalfHeight;
+	ESpecialMovementState state;
+	int8 wallNormal[3];
+
+	FVector getWallNormal() const { return FVector(wallNormal[0], wallNormal[1], wallNormal[2]) / 127.0f; }
+};
+
+/*
+ * Fixed size history of movement snapshots, one writer (game thread) and any number of readers.
+ * Readers never block the writer, a read that raced with an overwrite of its samples fails instead.
+ */
+class FMovementHistory
+{
+public:
+	static constexpr uint32 Capacity = 128;
+
+	void reset();
+	void push(FMovementSnapshot const & snapshot);
+
+	// snapshot interpolated at time, false when time is outside of the recorded window
+	bool rewind(double time, FMovementSnapshot& out) const;
+
+	double getOldestTime() const;
+
+private:
+	FMovementSnapshot mSamples[Capacity];
+	std::atomic<uint32> mWriteCount { 0 };
+};
+
+/*
+ * Server side movement history for lag compensation and hit validation.
+ * Records a snapshot every tick on the authority, memory is fixed per character and the hot path does not allocate.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class LOSTANDFOUND_API UMovementHistoryComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UMovementHistoryComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/* Movement state at serverTime (world time seconds on the server), interpolated between two snapshots. Safe from any thread. */
+	bool rewind(double serverTime, FMovementSnapshot& outSnapshot) const;
+
+	/* Test a line against the capsule of the character as it was at serverTime. Safe from any thread. */
+	bool rewindLineTest(double serverTime, FVector const & start, FVector const & end, FVector* outHitLocation = nullptr) const;
+
+	UFUNCTION(BlueprintCallable, Category = MovementHistory)
+	bool rewindLocation(float serverTime, FVector& location, ESpecialMovementState& state) const;
+
+	/* Forget all snapshots, a respawned character must not be rewound along its old path. */
+	void resetHistory();
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+	class ACharacter* owner;
+	class USpecialMovementComponent* specialMoves;
+
+	FMovementHistory mHistory;
+};
@@ -0,0 +1,218 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ParkourBenchmark.h"
+#include "lostandfoundCharacter.h"
+#include "ParkourMemory.h"
+#include "ParkourCharacterPool.h"
+#include "AIController.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "RenderCore.h"
+#include "RHI.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogParkourBenchmark, Log, All);
+
+bool UParkourBenchmarkSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* world = Cast<UWorld>(Outer);
+	return world && world->IsGameWorld() && FParse::Param(FCommandLine::Get(), TEXT("ParkourBenchmark"));
+}
+
+void UParkourBenchmarkSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FParse::Value(FCommandLine::Get(), TEXT("ParkourBenchmarkCharacters="), mNumCharacters);
+	FParse::Value(FCommandLine::Get(), TEXT("ParkourBenchmarkWarmup="), mWarmupTime);
+	FParse::Value(FCommandLine::Get(), TEXT("ParkourBenchmarkTime="), mCaptureTime);
+	mNumCharacters = FMath::Max(mNumCharacters, 1);
+
+	FString track;
+	if (FParse::Value(FCommandLine::Get(), TEXT("ParkourBenchmarkTrack="), track) && mScript.loadFromFile(track) == false) {
+		UE_LOG(LogParkourBenchmark, Error, TEXT("could not load input track %s, using the built-in one"), *track);
+	}
+
+	mStateFrames.SetNumZeroed(SpecialMovementTransitions::NumStates);
+
+#if !UE_BUILD_SHIPPING
+	mCheckAllocations = ParkourAllocationCheck::isInstalled();
+#endif
+}
+
+TStatId UParkourBenchmarkSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UParkourBenchmarkSubsystem, STATGROUP_Tickables);
+}
+
+void UParkourBenchmarkSubsystem::Tick(float DeltaTime)
+{
+	if (mPhase == EPhase::WAITING) {
+		if (spawnRunners()) {
+			mPhase = EPhase::WARMUP;
+			mPhaseTime = 0.0f;
+		}
+		return;
+	}
+	if (mPhase == EPhase::DONE) {
+		return;
+	}
+
+	for (FRunner& runner : mRunners) {
+		runner.script.tick(DeltaTime, runner.character.Get());
+	}
+
+	mPhaseTime += DeltaTime;
+
+	if (mPhase == EPhase::WARMUP) {
+		if (mPhaseTime >= mWarmupTime) {
+			beginCapture();
+		}
+		return;
+	}
+
+	// stat unit numbers of the last completed frame, render thread and gpu are zero with -nullrhi
+	FFrameSample& sample = mSamples.AddUninitialized_GetRef();
+	sample.frame = FApp::GetDeltaTime() * 1000.0f;
+	sample.game = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	sample.render = FPlatformTime::ToMilliseconds(GRenderThreadTime);
+	sample.gpu = FPlatformTime::ToMilliseconds(RHIGetGPUFrameCycles());
+
+	for (FRunner const & runner : mRunners) {
+		if (AlostandfoundCharacter* character = runner.character.Get()) {
+			mStateFrames[(int32)character->GetSpecialMoves()->mState]++;
+		}
+	}
+
+	if (mPhaseTime >= mCaptureTime) {
+		endCapture();
+	}
+}
+
+bool UParkourBenchmarkSubsystem::spawnRunners()
+{
+	UWorld* world = GetWorld();
+	APlayerController* controller = world->GetFirstPlayerController();
+	AlostandfoundCharacter* player = controller ? Cast<AlostandfoundCharacter>(controller->GetPawn()) : nullptr;
+	if (player == nullptr) {
+		return false;
+	}
+
+	mRunners.Add({ player, mScript });
+
+	// the other characters start in a row next to the player and run the same track, taken from the pool like any AI runner
+	UParkourCharacterPoolSubsystem* pool = world->GetSubsystem<UParkourCharacterPoolSubsystem>();
+	FActorSpawnParameters spawnParams;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	for (int32 i = 1; i < mNumCharacters; i++) {
+		FVector const location = player->GetActorLocation() + player->GetActorRightVector() * 150.0f * i;
+		AlostandfoundCharacter* character = pool
+			? pool->acquire(player->GetClass(), FTransform(player->GetActorRotation(), location))
+			: world->SpawnActor<AlostandfoundCharacter>(player->GetClass(), location, player->GetActorRotation(), spawnParams);
+		if (character == nullptr) {
+			continue;
+		}
+
+		character->SpawnDefaultController();
+		if (AAIController* ai = Cast<AAIController>(character->GetController())) {
+			// the script turns through the control rotation, do not let the pawn overwrite it
+			ai->bSetControlRotationFromPawnOrientation = false;
+			ai->SetControlRotation(player->GetActorRotation());
+		}
+		mRunners.Add({ character, mScript });
+	}
+
+	UE_LOG(LogParkourBenchmark, Display, TEXT("running %d characters, warmup %.1f s, capture %.1f s"), mRunners.Num(), mWarmupTime, mCaptureTime);
+	return true;
+}
+
+void UParkourBenchmarkSubsystem::beginCapture()
+{
+	mPhase = EPhase::CAPTURE;
+	mPhaseTime = 0.0f;
+	// 200 fps worth of samples, no reallocation while measuring
+	mSamples.Reset(FMath::CeilToInt(mCaptureTime * 200.0f));
+
+#if CSV_PROFILER
+	FCsvProfiler::Get()->BeginCapture();
+#endif
+
+#if !UE_BUILD_SHIPPING
+	// every move has run during the warmup, from here on the hot path must not touch the heap
+	ParkourAllocationCheck::arm(mCheckAllocations);
+#endif
+}
+
+void UParkourBenchmarkSubsystem::endCapture()
+{
+	mPhase = EPhase::DONE;
+
+#if CSV_PROFILER
+	FCsvProfiler::Get()->EndCapture();
+#endif
+
+	uint64 allocations = 0;
+#if !UE_BUILD_SHIPPING
+	allocations = ParkourAllocationCheck::getAllocations();
+	ParkourAllocationCheck::arm(false);
+#endif
+
+	writeSummary(allocations);
+	// a failing allocation check fails the run, so it can gate automated builds
+	FPlatformMisc::RequestExitWithStatus(false, mCheckAllocations && allocations > 0 ? 1 : 0);
+}
+
+void UParkourBenchmarkSubsystem::writeSummary(uint64 hotPathAllocations) const
+{
+	if (mSamples.Num() == 0) {
+		return;
+	}
+
+	auto stats = [this](float FFrameSample::* member, TCHAR const * name) {
+		TArray<float> values;
+		values.Reserve(mSamples.Num());
+		for (FFrameSample const & sample : mSamples) {
+			values.Add(sample.*member);
+		}
+		values.Sort();
+
+		double sum = 0.0;
+		for (float value : values) {
+			sum += value;
+		}
+		float const p95 = values[FMath::Min(FMath::FloorToInt(values.Num() * 0.95f), values.Num() - 1)];
+		return FString::Printf(TEXT("%s_ms avg %.3f min %.3f median %.3f p95 %.3f max %.3f\n"),
+			name, sum / values.Num(), values[0], values[values.Num() / 2], p95, values.Last());
+	};
+
+	FString summary;
+	summary += FString::Printf(TEXT("map %s\n"), *GetWorld()->GetMapName());
+	summary += FString::Printf(TEXT("build %s %s\n"), FApp::GetBuildVersion(), LexToString(FApp::GetBuildConfiguration()));
+	summary += FString::Printf(TEXT("characters %d\n"), mRunners.Num());
+	summary += FString::Printf(TEXT("frames %d\n"), mSamples.Num());
+	summary += stats(&FFrameSample::frame, TEXT("frame"));
+	summary += stats(&FFrameSample::game, TEXT("game"));
+	summary += stats(&FFrameSample::render, TEXT("render"));
+	summary += stats(&FFrameSample::gpu, TEXT("gpu"));
+
+	int32 totalStateFrames = 0;
+	for (int32 frames : mStateFrames) {
+		totalStateFrames += frames;
+	}
+	if (mCheckAllocations) {
+		summary += FString::Printf(TEXT("hot path allocations %llu\n"), hotPathAllocations);
+	}
+
+	UEnum const * states = StaticEnum<ESpecialMovementState>();
+	for (int32 i = 0; i < mStateFrames.Num(); i++) {
+		summary += FString::Printf(TEXT("state %s %.1f%%\n"), *states->GetNameStringByIndex(i), totalStateFrames > 0 ? 100.0f * mStateFrames[i] / totalStateFrames : 0.0f);
+	}
+
+	FString const path = FPaths::ProfilingDir() / TEXT("ParkourBenchmark") / FString::Printf(TEXT("%s_%s.txt"), *GetWorld()->GetMapName(), *FDateTime::Now().ToString());
+	FFileHelper::SaveStringToFile(summary, *path);
+
+	UE_LOG(LogParkourBenchmark, Display, TEXT("summary written to %s\n%s"), *path, *summary);
+}
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ParkourInputScript.h"
+#include "ParkourBenchmark.generated.h"
+
+class AlostandfoundCharacter;
+
+/*
+ * Repeatable frame cost benchmark on a parkour course.
+ *
+ * lostandfound ThirdPersonMap -ParkourBenchmark [-nullrhi -nosound -unattended]
+ *		-ParkourBenchmarkCharacters=N	number of scripted characters, the player plus N-1 AI controlled ones (default 1)
+ *		-ParkourBenchmarkTrack=file	input track, see FParkourInputScript::loadFromFile (default: built-in loop)
+ *		-ParkourBenchmarkWarmup=s	seconds before the capture starts (default 3)
+ *		-ParkourBenchmarkTime=s		captured seconds (default 60)
+ *
+ * With PARKOUR_ALLOCATION_CHECK=1 set in the environment (see ParkourMemory.h) the heap allocations in the special movement hot path
+ * are counted during the capture, the exit code is 1 when there are any.
+ *
+ * During the capture the CsvProfiler records to Saved/Profiling/CSV, the stat unit timings are collected
+ * and written as a summary to Saved/Profiling/ParkourBenchmark/<map>_<date>.txt. The game exits afterwards.
+ */
+UCLASS()
+class LOSTANDFOUND_API UParkourBenchmarkSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+private:
+	enum class EPhase : uint8
+	{
+		WAITING,
+		WARMUP,
+		CAPTURE,
+		DONE
+	};
+
+	struct FRunner
+	{
+		TWeakObjectPtr<AlostandfoundCharacter> character;
+		FParkourInputScript script;
+	};
+
+	/* stat unit timings of one frame, in ms */
+	struct FFrameSample
+	{
+		float frame;
+		float game;
+		float render;
+		float gpu;
+	};
+
+	bool spawnRunners();
+	void beginCapture();
+	void endCapture();
+	void writeSummary(uint64 hotPathAllocations) const;
+
+	EPhase mPhase = EPhase::WAITING;
+	float mPhaseTime = 0.0f;
+
+	int32 mNumCharacters = 1;
+	float mWarmupTime = 3.0f;
+	float mCaptureTime = 60.0f;
+	bool mCheckAllocations = false;
+	FParkourInputScript mScript = FParkourInputScript::makeDefault();
+
+	TArray<FRunner> mRunners;
+	TArray<FFrameSample> mSamples;
+	/* frames spent in each ESpecialMovementState over all runners, shows if the track hits every move */
+	TArray<int32> mStateFrames;
+};
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ParkourCameraModifier.h"
+#include "lostandfoundCharacter.h"
+#include "SpecialMovementComponent.h"
+#include "GameFramework/SpringArmComponent.h"
+
+bool UParkourCameraModifier::ModifyCamera(float DeltaTime, FVector ViewLocation, FRotator ViewRotation, float FOV, FVector& NewViewLocation, FRotator& NewViewRotation, float& NewFOV)
+{
+	Super::ModifyCamera(DeltaTime, ViewLocation, ViewRotation, FOV, NewViewLocation, NewViewRotation, NewFOV);
+
+	AlostandfoundCharacter* character = Cast<AlostandfoundCharacter>(GetViewTarget());
+	if (character == nullptr) {
+		return false;
+	}
+
+	USpecialMovementComponent* moves = character->GetSpecialMoves();
+	FSpecialMovementAnimSnapshot const & snapshot = moves->getAnimSnapshot();
+	bool const wallrunning = moves->mCorrectCamera && (snapshot.state == ESpecialMovementState::WALLRUN_LEFT || snapshot.state == ESpecialMovementState::WALLRUN_RIGHT);
+
+	// outer and inner corners change the wallrun direction, the offset follows smoothly
+	float targetYaw = 0.0f;
+	if (wallrunning) {
+		targetYaw = FMath::FindDeltaAngleDegrees(NewViewRotation.Yaw, snapshot.wallrunDir.Rotation().Yaw) * mLookAheadWeight;
+	}
+	mYawOffset = FMath::FInterpTo(mYawOffset, targetYaw, DeltaTime, mInterpSpeed);
+
+	if (FMath::IsNearlyZero(mYawOffset, 0.01f) == false) {
+		// orbit around the boom like a rotated control rotation would, without touching it
+		FRotator const offset(0.0f, mYawOffset, 0.0f);
+		FVector const pivot = character->GetCameraBoom()->GetComponentLocation();
+		NewViewLocation = pivot + offset.RotateVector(NewViewLocation - pivot);
+		NewViewRotation.Yaw += mYawOffset;
+	}
+
+	if (wallrunning) {
+		// the spring arm does not probe while wallrunning, keep the camera on the open side of the wall plane
+		float const distance = FVector::DotProduct(NewViewLocation - snapshot.wallImpact, snapshot.wallNormal);
+		if (distance < mWallClearance) {
+			NewViewLocation += snapshot.wallNormal * (mWallClearance - distance);
+		}
+	}
+
+	return false;
+}
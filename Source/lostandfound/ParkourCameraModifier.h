@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Camera/CameraModifier.h"
+#include "ParkourCameraModifier.generated.h"
+
+/*
+ * Look ahead camera for wallruns. Once per camera update the view is turned towards the wallrun direction
+ * around the camera boom pivot and kept in front of the wall, both from the special movement snapshot.
+ * Only the view is changed, the control rotation stays with the player.
+ * Added to the player camera manager by AlostandfoundCharacter.
+ */
+UCLASS()
+class LOSTANDFOUND_API UParkourCameraModifier : public UCameraModifier
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ModifyCamera(float DeltaTime, FVector ViewLocation, FRotator ViewRotation, float FOV, FVector& NewViewLocation, FRotator& NewViewRotation, float& NewFOV) override;
+
+	/* Share of the angle between view and wallrun direction the view is turned by. 1.0 looks straight along the wall. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (ClampMin = "0.0", ClampMax = "1.0", UIMin = "0.0", UIMax = "1.0"))
+	float mLookAheadWeight = 0.5f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float mInterpSpeed = 4.0f;
+
+	/* Minimum distance between camera and wall while wallrunning. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float mWallClearance = 30.0f;
+
+private:
+	float mYawOffset = 0.0f;
+};
@@ -0,0 +1,154 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ParkourCharacterPool.h"
+#include "lostandfoundCharacter.h"
+#include "ParkourSignificance.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/Controller.h"
+#include "TimerManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogParkourCharacterPool, Log, All);
+
+bool UParkourCharacterPoolSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* world = Cast<UWorld>(Outer);
+	return world && world->IsGameWorld();
+}
+
+void UParkourCharacterPoolSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// characters are spawned by the server and replicated, clients do not keep a pool of their own
+	if (InWorld.GetNetMode() == NM_Client || mDefaultClass == nullptr) {
+		return;
+	}
+
+	// the game mode resolved the class before the actors began play. Spawn on the next tick, characters spawned now
+	// would only begin play (and register for significance) after they were released into the pool
+	InWorld.GetTimerManager().SetTimerForNextTick(FTimerDelegate::CreateWeakLambda(this, [this]() {
+		prewarm(mDefaultClass, mPoolSize);
+	}));
+}
+
+void UParkourCharacterPoolSubsystem::setDefaultClass(TSubclassOf<AlostandfoundCharacter> characterClass)
+{
+	mDefaultClass = characterClass;
+
+	// before begin play the pool is filled by OnWorldBeginPlay
+	if (GetWorld()->HasBegunPlay() && GetWorld()->GetNetMode() != NM_Client) {
+		prewarm(mDefaultClass, mPoolSize);
+	}
+}
+
+AlostandfoundCharacter* UParkourCharacterPoolSubsystem::acquire(TSubclassOf<AlostandfoundCharacter> characterClass, FTransform const & transform)
+{
+	if (characterClass == nullptr) {
+		return nullptr;
+	}
+
+	int32 const index = mPool.FindLastByPredicate([&](AlostandfoundCharacter const* character) {
+		return IsValid(character) && character->GetClass() == characterClass;
+	});
+	if (index == INDEX_NONE) {
+		UE_LOG(LogParkourCharacterPool, Log, TEXT("no pooled %s, spawning a new one"), *characterClass->GetName());
+		return spawnCharacter(characterClass, transform);
+	}
+
+	AlostandfoundCharacter* character = mPool[index];
+	mPool.RemoveAtSwap(index);
+	activate(character, transform);
+	return character;
+}
+
+void UParkourCharacterPoolSubsystem::release(AlostandfoundCharacter* character)
+{
+	if (IsValid(character) == false || mPool.Contains(character)) {
+		return;
+	}
+
+	deactivate(character);
+	mPool.Add(character);
+}
+
+void UParkourCharacterPoolSubsystem::prewarm(TSubclassOf<AlostandfoundCharacter> characterClass, int32 count)
+{
+	if (characterClass == nullptr) {
+		return;
+	}
+
+	// spawned far below the level, deactivate moves nothing
+	FTransform const parking(FVector(0.0f, 0.0f, -100000.0f));
+	for (int32 i = getNumPooled(characterClass); i < count; i++) {
+		if (AlostandfoundCharacter* character = spawnCharacter(characterClass, parking)) {
+			release(character);
+		}
+	}
+}
+
+int32 UParkourCharacterPoolSubsystem::getNumPooled(TSubclassOf<AlostandfoundCharacter> characterClass) const
+{
+	int32 count = 0;
+	for (AlostandfoundCharacter const* character : mPool) {
+		count += IsValid(character) && character->GetClass() == characterClass;
+	}
+	return count;
+}
+
+AlostandfoundCharacter* UParkourCharacterPoolSubsystem::spawnCharacter(TSubclassOf<AlostandfoundCharacter> characterClass, FTransform const & transform) const
+{
+	FActorSpawnParameters spawnParams;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return GetWorld()->SpawnActor<AlostandfoundCharacter>(characterClass, transform, spawnParams);
+}
+
+void UParkourCharacterPoolSubsystem::deactivate(AlostandfoundCharacter* character)
+{
+	if (AController* controller = character->GetController()) {
+		controller->UnPossess();
+		// players get a pooled character through RestartPlayer, AI controllers are spawned again with the character
+		if (controller->IsPlayerController() == false) {
+			controller->Destroy();
+		}
+	}
+
+	if (UParkourSignificanceSubsystem* significance = GetWorld()->GetSubsystem<UParkourSignificanceSubsystem>()) {
+		significance->unregisterCharacter(character);
+	}
+
+	character->resetState();
+	character->GetCharacterMovement()->DisableMovement();
+
+	character->SetActorHiddenInGame(true);
+	character->SetActorEnableCollision(false);
+	character->SetActorTickEnabled(false);
+	for (UActorComponent* component : character->GetComponents()) {
+		component->SetComponentTickEnabled(false);
+	}
+
+	// the hidden state is replicated once more, then the pooled character costs the net driver nothing
+	character->FlushNetDormancy();
+	character->SetNetDormancy(DORM_DormantAll);
+}
+
+void UParkourCharacterPoolSubsystem::activate(AlostandfoundCharacter* character, FTransform const & transform)
+{
+	character->SetNetDormancy(DORM_Awake);
+	character->SetActorTransform(transform, false, nullptr, ETeleportType::ResetPhysics);
+
+	character->SetActorHiddenInGame(false);
+	character->SetActorEnableCollision(true);
+	character->SetActorTickEnabled(true);
+	for (UActorComponent* component : character->GetComponents()) {
+		if (component->PrimaryComponentTick.bStartWithTickEnabled) {
+			component->SetComponentTickEnabled(true);
+		}
+	}
+
+	// also back to the full rate significance settings, registering applies the bucket for the new location
+	character->resetState();
+
+	if (UParkourSignificanceSubsystem* significance = GetWorld()->GetSubsystem<UParkourSignificanceSubsystem>()) {
+		significance->registerCharacter(character);
+	}
+}
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ParkourCharacterPool.generated.h"
+
+class AlostandfoundCharacter;
+
+/*
+ * Pre-spawned characters for AI runners and respawns. A released character is unpossessed, hidden, made net dormant and
+ * reset through AlostandfoundCharacter::resetState, acquire places and activates it again without constructing components.
+ * The pool of the player pawn class is filled once AlostandfoundGameMode resolved it from the startup content, other classes are pooled once released.
+ * Players respawn through AlostandfoundGameMode::SpawnDefaultPawnAtTransform, a character falling out of the world is released.
+ */
+UCLASS(config=Game)
+class LOSTANDFOUND_API UParkourCharacterPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/* Take a pooled character of the class, a new one is spawned when the pool is empty. */
+	UFUNCTION(BlueprintCallable, Category = CharacterPool)
+	AlostandfoundCharacter* acquire(TSubclassOf<AlostandfoundCharacter> characterClass, FTransform const & transform);
+
+	/* Return a character on death or restart instead of destroying it. */
+	UFUNCTION(BlueprintCallable, Category = CharacterPool)
+	void release(AlostandfoundCharacter* character);
+
+	/* Spawn characters into the pool until count of the class are available. */
+	UFUNCTION(BlueprintCallable, Category = CharacterPool)
+	void prewarm(TSubclassOf<AlostandfoundCharacter> characterClass, int32 count);
+
+	UFUNCTION(BlueprintPure, Category = CharacterPool)
+	int32 getNumPooled(TSubclassOf<AlostandfoundCharacter> characterClass) const;
+
+	/* Fill the pool with mPoolSize characters of the class, right away or when the world begins play. Called by the game mode with the resolved pawn class. */
+	void setDefaultClass(TSubclassOf<AlostandfoundCharacter> characterClass);
+
+	/* Characters of the default class spawned into the pool. */
+	UPROPERTY(config, EditAnywhere, Category = CharacterPool)
+	int32 mPoolSize = 8;
+
+private:
+	AlostandfoundCharacter* spawnCharacter(TSubclassOf<AlostandfoundCharacter> characterClass, FTransform const & transform) const;
+	void deactivate(AlostandfoundCharacter* character);
+	void activate(AlostandfoundCharacter* character, FTransform const & transform);
+
+	UPROPERTY(Transient)
+	TArray<AlostandfoundCharacter*> mPool;
+
+	UPROPERTY(Transient)
+	TSubclassOf<AlostandfoundCharacter> mDefaultClass;
+};
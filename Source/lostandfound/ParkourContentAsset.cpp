@@ -0,0 +1,11 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ParkourContentAsset.h"
+
+const FPrimaryAssetType UParkourContentAsset::AssetType(TEXT("ParkourContent"));
+const FName UParkourContentAsset::StartupBundle(TEXT("Startup"));
+
+FPrimaryAssetId UParkourContentAsset::GetPrimaryAssetId() const
+{
+	return FPrimaryAssetId(AssetType, GetFName());
+}
@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "ParkourContentAsset.generated.h"
+
+/*
+ * Primary asset listing the player character and the parkour content it needs (animations, Mixamo rig, meshes).
+ * Everything in the Startup bundle is streamed in by AlostandfoundGameMode while the map loads.
+ * Place instances in /Game/Parkour, they are found by the asset manager as ParkourContent:<name>.
+ */
+UCLASS()
+class LOSTANDFOUND_API UParkourContentAsset : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	static const FPrimaryAssetType AssetType;
+	static const FName StartupBundle;
+
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Startup, meta = (AssetBundles = "Startup"))
+	TSoftClassPtr<APawn> mCharacterClass;
+
+	/* Additional content needed before the first spawn. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Startup, meta = (AssetBundles = "Startup"))
+	TArray<TSoftObjectPtr<UObject>> mStartupAssets;
+};
@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ParkourInputScript.h"
+#include "lostandfoundCharacter.h"
+#include "GameFramework/Controller.h"
+#include "Misc/FileHelper.h"
+
+FParkourInputScript FParkourInputScript::makeDefault()
+{
+	FParkourInputScript script;
+	script.mSteps = {
+		// duration, forward, right, jump, slide, turnYaw
+		{ 1.0f, 1.0f,  0.0f, false, false,  0.0f },
+		{ 0.6f, 1.0f,  1.0f, false, false,  0.0f },
+		{ 0.1f, 1.0f,  0.0f, true,  false,  0.0f },
+		{ 0.8f, 1.0f,  0.0f, false, false,  0.0f },
+		{ 0.6f, 1.0f, -1.0f, false, false,  0.0f },
+		{ 0.1f, 1.0f,  0.0f, true,  false,  0.0f },
+		{ 1.0f, 1.0f,  0.0f, false, false,  0.0f },
+		{ 0.8f, 1.0f,  0.0f, false, true,   0.0f },
+		{ 0.1f, 1.0f,  0.0f, true,  false,  0.0f },
+		{ 0.5f, 0.0f,  0.0f, false, false, 90.0f }
+	};
+	return script;
+}
+
+FParkourInputScript FParkourInputScript::makeFromSteps(TArray<FStep> steps)
+{
+	FParkourInputScript script;
+	script.mSteps = MoveTemp(steps);
+	return script;
+}
+
+bool FParkourInputScript::loadFromFile(FString const & path)
+{
+	TArray<FString> lines;
+	if (FFileHelper::LoadFileToStringArray(lines, *path) == false) {
+		return false;
+	}
+
+	TArray<FStep> steps;
+	for (FString const & line : lines) {
+		if (line.IsEmpty() || line.StartsWith(TEXT("#"))) {
+			continue;
+		}
+
+		TArray<FString> values;
+		line.ParseIntoArray(values, TEXT(","));
+		if (values.Num() != 6) {
+			return false;
+		}
+
+		FStep& step = steps.AddDefaulted_GetRef();
+		step.duration = FCString::Atof(*values[0]);
+		step.forward = FCString::Atof(*values[1]);
+		step.right = FCString::Atof(*values[2]);
+		step.jump = FCString::Atoi(*values[3]) != 0;
+		step.slide = FCString::Atoi(*values[4]) != 0;
+		step.turnYaw = FCString::Atof(*values[5]);
+	}
+
+	if (steps.Num() == 0) {
+		return false;
+	}
+
+	mSteps = MoveTemp(steps);
+	restart();
+	return true;
+}
+
+void FParkourInputScript::restart()
+{
+	mStep = 0;
+	mStepTime = 0.0f;
+	mStepStarted = false;
+}
+
+void FParkourInputScript::tick(float time, AlostandfoundCharacter* character)
+{
+	AController* controller = character ? character->GetController() : nullptr;
+	if (controller == nullptr || mSteps.Num() == 0) {
+		return;
+	}
+
+	FStep const & step = mSteps[mStep];
+
+	bool const first = mStepStarted == false;
+	mStepStarted = true;
+	if (first && step.turnYaw != 0.0f) {
+		controller->SetControlRotation(controller->GetControlRotation() + FRotator(0.0f, step.turnYaw, 0.0f));
+	}
+	character->applyBotInput(step.forward, step.right, first && step.jump, first && step.slide);
+
+	mStepTime += time;
+	if (mStepTime >= step.duration) {
+		mStepTime = 0.0f;
+		mStepStarted = false;
+		mStep = (mStep + 1) % mSteps.Num();
+	}
+}
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AlostandfoundCharacter;
+
+/*
+ * Scripted input track for bots and benchmarks. Every step holds movement axes for its duration,
+ * jump, slide and turn are triggered once when the step starts. The script loops.
+ */
+class LOSTANDFOUND_API FParkourInputScript
+{
+public:
+	struct FStep
+	{
+		float duration;
+		float forward;
+		float right;
+		bool jump;
+		bool slide;
+		float turnYaw;
+	};
+
+	/* Run along, veer into walls on both sides to wallrun through corners, jump off, slide into a boosted jump and turn. */
+	static FParkourInputScript makeDefault();
+
+	/* Steps given in code, for tests that need a fixed sequence. Loops like every script, run it for the sum of the durations to play it once. */
+	static FParkourInputScript makeFromSteps(TArray<FStep> steps);
+
+	/* One step per line: duration,forward,right,jump,slide,turnYaw. Lines starting with # are skipped. */
+	bool loadFromFile(FString const & path);
+
+	/* Advance the script by time and feed the character through its input handlers. */
+	void tick(float time, AlostandfoundCharacter* character);
+
+	void restart();
+
+private:
+	TArray<FStep> mSteps;
+	int32 mStep = 0;
+	float mStepTime = 0.0f;
+	bool mStepStarted = false;
+};
@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ParkourLoadHarness.h"
+#include "lostandfoundCharacter.h"
+#include "EngineUtils.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogParkourLoadHarness, Log, All);
+
+bool UParkourBotSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* world = Cast<UWorld>(Outer);
+	return world && world->IsGameWorld() && FParse::Param(FCommandLine::Get(), TEXT("ParkourBot"));
+}
+
+TStatId UParkourBotSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UParkourBotSubsystem, STATGROUP_Tickables);
+}
+
+void UParkourBotSubsystem::Tick(float DeltaTime)
+{
+	APlayerController* controller = GetWorld()->GetFirstPlayerController();
+	AlostandfoundCharacter* character = controller ? Cast<AlostandfoundCharacter>(controller->GetPawn()) : nullptr;
+	if (character == nullptr) {
+		return;
+	}
+
+	mScript.tick(DeltaTime, character);
+}
+
+bool UParkourLoadHarnessSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* world = Cast<UWorld>(Outer);
+	return world && world->IsGameWorld() && FParse::Param(FCommandLine::Get(), TEXT("ParkourLoadHarness"));
+}
+
+void UParkourLoadHarnessSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	mTickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &UParkourLoadHarnessSubsystem::onWorldTickStart);
+	mPostTickFlushHandle = GetWorld()->OnPostTickFlush().AddUObject(this, &UParkourLoadHarnessSubsystem::onPostTickFlush);
+}
+
+void UParkourLoadHarnessSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldTickStart.Remove(mTickStartHandle);
+	GetWorld()->OnPostTickFlush().Remove(mPostTickFlushHandle);
+
+	Super::Deinitialize();
+}
+
+TStatId UParkourLoadHarnessSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UParkourLoadHarnessSubsystem, STATGROUP_Tickables);
+}
+
+void UParkourLoadHarnessSubsystem::onWorldTickStart(UWorld* world, ELevelTick tickType, float deltaSeconds)
+{
+	if (world == GetWorld()) {
+		mTickStartTime = FPlatformTime::Seconds();
+	}
+}
+
+void UParkourLoadHarnessSubsystem::onPostTickFlush(float deltaSeconds)
+{
+	// the flush replicates actors to all connections, the cost that grows the most with the bot count
+	double const tickTime = (FPlatformTime::Seconds() - mTickStartTime) * 1000.0;
+	mTickTimeSum += tickTime;
+	mTickTimeMax = FMath::Max(mTickTimeMax, tickTime);
+	mFrames++;
+}
+
+void UParkourLoadHarnessSubsystem::Tick(float DeltaTime)
+{
+	countCorrections();
+
+	mReportTime += DeltaTime;
+	if (mReportTime >= mReportInterval) {
+		writeReport();
+		mReportTime = 0.0f;
+		mFrames = 0;
+		mTickTimeSum = 0.0;
+		mTickTimeMax = 0.0;
+		mCorrections = 0;
+	}
+}
+
+void UParkourLoadHarnessSubsystem::countCorrections()
+{
+	// a rejected client move leaves a pending adjustment that is sent when the net driver replicates
+	for (TActorIterator<AlostandfoundCharacter> it(GetWorld()); it; ++it) {
+		UCharacterMovementComponent* move = it->GetCharacterMovement();
+		if (move == nullptr || move->HasPredictionData_Server() == false) {
+			continue;
+		}
+
+		FNetworkPredictionData_Server_Character const* serverData = move->GetPredictionData_Server_Character();
+		if (serverData->PendingAdjustment.TimeStamp > 0.0f && serverData->PendingAdjustment.bAckGoodMove == false) {
+			mCorrections++;
+		}
+	}
+}
+
+void UParkourLoadHarnessSubsystem::writeReport()
+{
+	UNetDriver* netDriver = GetWorld()->GetNetDriver();
+	int32 const connections = netDriver ? netDriver->ClientConnections.Num() : 0;
+
+	int64 inBytes = 0;
+	int64 outBytes = 0;
+	if (netDriver) {
+		for (UNetConnection* connection : netDriver->ClientConnections) {
+			inBytes += connection->InBytesPerSecond;
+			outBytes += connection->OutBytesPerSecond;
+		}
+	}
+
+	double const avgTick = mFrames > 0 ? mTickTimeSum / mFrames : 0.0;
+	double const inPerConnection = connections > 0 ? (double)inBytes / connections : 0.0;
+	double const outPerConnection = connections > 0 ? (double)outBytes / connections : 0.0;
+	double const correctionsPerSecond = mCorrections / mReportTime;
+
+	UE_LOG(LogParkourLoadHarness, Display, TEXT("bots %d, tick avg %.2f ms max %.2f ms, per connection in %.0f B/s out %.0f B/s, corrections %.1f/s"),
+		connections, avgTick, mTickTimeMax, inPerConnection, outPerConnection, correctionsPerSecond);
+
+	FString const path = FPaths::ProfilingDir() / TEXT("ParkourLoadHarness.csv");
+	if (IFileManager::Get().FileExists(*path) == false) {
+		FFileHelper::SaveStringToFile(TEXT("time,bots,tick_avg_ms,tick_max_ms,in_bytes_per_connection,out_bytes_per_connection,corrections_per_second\n"), *path);
+	}
+
+	FString const row = FString::Printf(TEXT("%.1f,%d,%.3f,%.3f,%.0f,%.0f,%.2f\n"),
+		GetWorld()->GetRealTimeSeconds(), connections, avgTick, mTickTimeMax, inPerConnection, outPerConnection, correctionsPerSecond);
+	FFileHelper::SaveStringToFile(row, *path, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+}
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ParkourInputScript.h"
+#include "ParkourLoadHarness.generated.h"
+
+/*
+ * Local bot swarm load test.
+ *
+ * server:	lostandfoundServer -log -ParkourLoadHarness
+ * bots:	lostandfound 127.0.0.1 -nullrhi -nosound -ParkourBot		(start as many as needed)
+ *
+ * Every bot client runs a scripted wallrun / slide / jump loop through the regular character input handlers.
+ * The server appends tick time (world tick start through the net driver flush, so replication is included), per connection bandwidth
+ * and movement corrections to Saved/Profiling/ParkourLoadHarness.csv.
+ */
+
+/* Client side: drives the locally controlled character with the bot script. Only created with -ParkourBot. */
+UCLASS()
+class LOSTANDFOUND_API UParkourBotSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+private:
+	FParkourInputScript mScript = FParkourInputScript::makeDefault();
+};
+
+/* Server side: measures the cost of all connected bots. Only created with -ParkourLoadHarness. */
+UCLASS()
+class LOSTANDFOUND_API UParkourLoadHarnessSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/* Seconds between two report rows. */
+	float mReportInterval = 5.0f;
+
+private:
+	void onWorldTickStart(UWorld* world, ELevelTick tickType, float deltaSeconds);
+	void onPostTickFlush(float deltaSeconds);
+	void countCorrections();
+	void writeReport();
+
+	FDelegateHandle mTickStartHandle;
+	FDelegateHandle mPostTickFlushHandle;
+	double mTickStartTime = 0.0;
+
+	float mReportTime = 0.0f;
+	int32 mFrames = 0;
+	double mTickTimeSum = 0.0;
+	double mTickTimeMax = 0.0;
+	int32 mCorrections = 0;
+};
@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ParkourMemory.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformMisc.h"
+#include <atomic>
+
+LLM_DEFINE_TAG(Parkour);
+
+#if !UE_BUILD_SHIPPING
+
+DEFINE_LOG_CATEGORY_STATIC(LogParkourAllocation, Log, All);
+
+namespace ParkourAllocationCheck
+{
+	static thread_local int32 GScopeDepth = 0;
+	static thread_local uint64 GThreadAllocations = 0;
+	static std::atomic<bool> GArmed { false };
+	static std::atomic<uint64> GAllocations { 0 };
+	static std::atomic<int32> GReported { 0 };
+
+	// forwards everything, only counts on threads that are inside a scope
+	class FCountingMalloc final : public FMalloc
+	{
+	public:
+		explicit FCountingMalloc(FMalloc* inner) : mInner(inner) {}
+
+		virtual void* Malloc(SIZE_T count, uint32 alignment) override { countAllocation(); return mInner->Malloc(count, alignment); }
+		virtual void* TryMalloc(SIZE_T count, uint32 alignment) override { countAllocation(); return mInner->TryMalloc(count, alignment); }
+		virtual void* Realloc(void* original, SIZE_T count, uint32 alignment) override { countAllocation(); return mInner->Realloc(original, count, alignment); }
+		virtual void* TryRealloc(void* original, SIZE_T count, uint32 alignment) override { countAllocation(); return mInner->TryRealloc(original, count, alignment); }
+		virtual void Free(void* original) override { mInner->Free(original); }
+
+		virtual SIZE_T QuantizeSize(SIZE_T count, uint32 alignment) override { return mInner->QuantizeSize(count, alignment); }
+		virtual bool GetAllocationSize(void* original, SIZE_T& outSize) override { return mInner->GetAllocationSize(original, outSize); }
+		virtual void Trim(bool trimThreadCaches) override { mInner->Trim(trimThreadCaches); }
+		virtual void SetupTLSCachesOnCurrentThread() override { mInner->SetupTLSCachesOnCurrentThread(); }
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { mInner->ClearAndDisableTLSCachesOnCurrentThread(); }
+		virtual void InitializeStatsMetadata() override { mInner->InitializeStatsMetadata(); }
+		virtual void UpdateStats() override { mInner->UpdateStats(); }
+		virtual void GetAllocatorStats(FGenericMemoryStats& outStats) override { mInner->GetAllocatorStats(outStats); }
+		virtual void DumpAllocatorStats(FOutputDevice& ar) override { mInner->DumpAllocatorStats(ar); }
+		virtual bool IsInternallyThreadSafe() const override { return mInner->IsInternallyThreadSafe(); }
+		virtual bool ValidateHeap() override { return mInner->ValidateHeap(); }
+		virtual const TCHAR* GetDescriptiveName() override { return mInner->GetDescriptiveName(); }
+		virtual void OnMallocInitialized() override { mInner->OnMallocInitialized(); }
+		virtual void OnPreFork() override { mInner->OnPreFork(); }
+		virtual void OnPostFork() override { mInner->OnPostFork(); }
+
+	private:
+		FMalloc* mInner;
+
+		FORCEINLINE void countAllocation()
+		{
+			if (GScopeDepth > 0) {
+				GThreadAllocations++;
+			}
+		}
+	};
+
+	static bool GInstalled = false;
+
+#if IS_MONOLITHIC
+	// installed during static initialization, before the engine starts any thread and before PreInit calls OnMallocInitialized.
+	// The command line is not parsed yet at this point, so the switch is an environment variable.
+	static struct FInstaller
+	{
+		FInstaller()
+		{
+			if (FPlatformMisc::GetEnvironmentVariable(TEXT("PARKOUR_ALLOCATION_CHECK")).IsEmpty()) {
+				return;
+			}
+			// the first allocation creates the platform allocator
+			FMemory::Free(FMemory::Malloc(16));
+			// never removed, memory allocated through the proxy is freed through it as well
+			GMalloc = new FCountingMalloc(GMalloc);
+			GInstalled = true;
+		}
+	} GInstaller;
+#endif
+
+	bool isInstalled()
+	{
+		return GInstalled;
+	}
+
+	void arm(bool armed)
+	{
+		if (armed) {
+			GAllocations.store(0);
+			GReported.store(0);
+		}
+		GArmed.store(armed && isInstalled());
+	}
+
+	uint64 getAllocations()
+	{
+		return GAllocations.load();
+	}
+
+	FScope::FScope(TCHAR const * name)
+		: mName(name)
+		, mStartCount(GThreadAllocations)
+	{
+		GScopeDepth++;
+	}
+
+	FScope::~FScope()
+	{
+		GScopeDepth--;
+
+		uint64 const allocations = GThreadAllocations - mStartCount;
+		if (allocations == 0 || GArmed.load(std::memory_order_relaxed) == false) {
+			return;
+		}
+
+		GAllocations.fetch_add(allocations);
+		// logging allocates as well, outside of the scope and only the first few times
+		if (GReported.fetch_add(1) < 10) {
+			UE_LOG(LogParkourAllocation, Error, TEXT("%llu heap allocations in %s"), allocations, mName);
+		}
+	}
+}
+
+#endif
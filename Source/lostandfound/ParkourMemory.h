@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+
+/* LLM tag of the special movement and spline code, visible with -llm in stat LLM and memreport. */
+LLM_DECLARE_TAG_API(Parkour, LOSTANDFOUND_API);
+
+/*
+ * Development check for the allocation free hot paths, enabled with the environment variable PARKOUR_ALLOCATION_CHECK=1
+ * in monolithic builds (game, server, client). GMalloc is wrapped with a counting proxy before the engine starts,
+ * heap allocations on a thread inside an FScope are counted once the check is armed.
+ * Arm it after a warmup so one-off growth (timer heap, thread buffers) does not count,
+ * see the lostandfound.SpecialMovement.AllocationFree automation test and UParkourBenchmarkSubsystem.
+ */
+namespace ParkourAllocationCheck
+{
+#if !UE_BUILD_SHIPPING
+	LOSTANDFOUND_API bool isInstalled();
+	LOSTANDFOUND_API void arm(bool armed);
+
+	/* Allocations inside armed scopes since the last arm(true). */
+	LOSTANDFOUND_API uint64 getAllocations();
+
+	class LOSTANDFOUND_API FScope
+	{
+	public:
+		explicit FScope(TCHAR const * name);
+		~FScope();
+
+	private:
+		TCHAR const * mName;
+		uint64 mStartCount;
+	};
+#endif
+}
+
+#if !UE_BUILD_SHIPPING
+#define PARKOUR_ALLOCATION_CHECK_SCOPE(Name) ParkourAllocationCheck::FScope ParkourAllocationScope_##Name(TEXT(#Name))
+#else
+#define PARKOUR_ALLOCATION_CHECK_SCOPE(Name)
+#endif
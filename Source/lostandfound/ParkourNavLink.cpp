@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ParkourNavLink.h"
+#include "lostandfoundCharacter.h"
+#include "NavLinkCustomComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+const FName AParkourNavLink::GeneratedTag(TEXT("ParkourGenerated"));
+
+AParkourNavLink::AParkourNavLink()
+{
+	// only the smart link is used, it carries the parkour annotations
+	PointLinks.Empty();
+	bSmartLinkIsRelevant = true;
+
+	// ticks only while characters are on the link
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	Tags.Add(GeneratedTag);
+}
+
+void AParkourNavLink::BeginPlay()
+{
+	Super::BeginPlay();
+
+	OnSmartLinkReached.AddDynamic(this, &AParkourNavLink::onSmartLinkReached);
+}
+
+void AParkourNavLink::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	for (int32 i = mTraversals.Num() - 1; i >= 0; i--) {
+		if (updateTraversal(mTraversals[i])) {
+			if (AlostandfoundCharacter* character = mTraversals[i].character.Get()) {
+				ResumePathFollowing(character);
+			}
+			mTraversals.RemoveAtSwap(i);
+		}
+	}
+
+	SetActorTickEnabled(mTraversals.Num() > 0);
+}
+
+void AParkourNavLink::onSmartLinkReached(AActor* agent, const FVector& destination)
+{
+	AlostandfoundCharacter* character = Cast<AlostandfoundCharacter>(agent);
+	if (character == nullptr) {
+		// nothing else can do the move, let it repath
+		ResumePathFollowing(agent);
+		return;
+	}
+
+	startTraversal(character);
+	mTraversals.Add({ character, GetWorld()->GetTimeSeconds(), false, false, false });
+	SetActorTickEnabled(true);
+}
+
+void AParkourNavLink::startTraversal(AlostandfoundCharacter* character) const
+{
+	UCharacterMovementComponent* move = character->GetCharacterMovement();
+	// the generator simulated the move with the entry speed, arriving faster only makes it further
+	float const speed = FMath::Max(FVector2D(move->Velocity).Length(), mRequiredEntrySpeed);
+
+	if (mType == EParkourLinkType::JUMP_BOOST) {
+		// same launch the generator predicted the landing for
+		FLaunchQuery query;
+		query.location = character->GetActorLocation();
+		query.velocity = mEntryDirection * speed;
+		query.inputDir = mEntryDirection;
+		query.jumpBoost = true;
+
+		character->SetActorRotation(mEntryDirection.Rotation());
+		character->LaunchCharacter(query.velocity + character->GetSpecialMoves()->predictLaunchVelocity(query), true, true);
+		return;
+	}
+
+	// the entry direction runs along the wall, calcWallrunDir crossed the wall normal with up (left) or down (right)
+	FVector const wallNormal = mRequiredState == ESpecialMovementState::WALLRUN_LEFT
+		? FVector::CrossProduct(FVector::UpVector, mEntryDirection)
+		: FVector::CrossProduct(mEntryDirection, FVector::UpVector);
+
+	// face along the wall so the wall ends up on the annotated side, then jump at it
+	character->SetActorRotation(mEntryDirection.Rotation());
+	FVector const velocity = mEntryDirection * speed - wallNormal * speed * 0.5f;
+	character->LaunchCharacter(FVector(velocity.X, velocity.Y, move->JumpZVelocity), true, true);
+}
+
+bool AParkourNavLink::updateTraversal(FTraversal& traversal) const
+{
+	AlostandfoundCharacter* character = traversal.character.Get();
+	if (character == nullptr) {
+		return true;
+	}
+
+	if (GetWorld()->GetTimeSeconds() - traversal.startTime > mMaxTraversalTime) {
+		return true;
+	}
+
+	UCharacterMovementComponent const* move = character->GetCharacterMovement();
+	USpecialMovementComponent* moves = character->GetSpecialMoves();
+	ESpecialMovementState const state = moves->getAnimSnapshot().state;
+	bool const wallrunning = state == ESpecialMovementState::WALLRUN_LEFT || state == ESpecialMovementState::WALLRUN_RIGHT;
+
+	// the wallrun ended at the end of the wall, jump off within the coyote time like the generator did
+	if (traversal.wasWallrunning && wallrunning == false && traversal.jumpedOff == false && move->IsFalling()) {
+		moves->Jump();
+		traversal.jumpedOff = true;
+	}
+	traversal.wasWallrunning = wallrunning;
+
+	// the launch is applied by the next movement tick, done once it left the ground and landed again
+	traversal.leftGround |= move->IsMovingOnGround() == false;
+	return traversal.leftGround && move->IsMovingOnGround();
+}
+void AParkourNavLink::setLink(FVector const & end, EParkourLinkType type, ESpecialMovementState requiredState, float requiredEntrySpeed, FVector const & entryDirection)
+{
+	mType = type;
+	mRequiredState = requiredState;
+	mRequiredEntrySpeed = requiredEntrySpeed;
+	mEntryDirection = entryDirection;
+
+	FVector const relativeEnd = GetActorTransform().InverseTransformPosition(end);
+	GetSmartLinkComp()->SetLinkData(FVector::ZeroVector, relativeEnd, ENavLinkDirection::LeftToRight);
+}
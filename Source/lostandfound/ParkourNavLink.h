@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Navigation/NavLinkProxy.h"
+#include "SpecialMovementComponent.h"
+#include "ParkourNavLink.generated.h"
+
+UENUM(BlueprintType)
+enum class EParkourLinkType : uint8
+{
+	WALLJUMP		UMETA(DisplayName = "Wallrun + Walljump"),
+	JUMP_BOOST		UMETA(DisplayName = "Jump Boost")
+};
+
+/*
+ * Smart nav link for a parkour move, generated offline by AParkourNavLinkGenerator.
+ * An AI reaching the link is launched into the move with the annotated speed and state: a jump boost off the edge,
+ * or a jump onto the wall on the annotated side and a walljump when the wallrun ends. Path following resumes after landing.
+ */
+UCLASS()
+class LOSTANDFOUND_API AParkourNavLink : public ANavLinkProxy
+{
+	GENERATED_BODY()
+
+public:
+	AParkourNavLink();
+
+	virtual void BeginPlay() override;
+	virtual void Tick(float DeltaSeconds) override;
+
+	/* Setup the smart link from this actors location to end (world space). */
+	void setLink(FVector const & end, EParkourLinkType type, ESpecialMovementState requiredState, float requiredEntrySpeed, FVector const & entryDirection);
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Parkour)
+	EParkourLinkType mType;
+
+	/* State the character has to be in to use the link, e.g. the wallrun side. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Parkour)
+	ESpecialMovementState mRequiredState;
+
+	/* Horizontal speed the character needs when entering the link. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Parkour)
+	float mRequiredEntrySpeed;
+
+	/* Direction to run into when entering the link. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Parkour)
+	FVector mEntryDirection;
+
+	/* Path following resumes after this many seconds even if the character did not land, it repaths from wherever it is. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Parkour)
+	float mMaxTraversalTime = 4.0f;
+
+	/* Tag of all links created by the generator, used to clear them before regenerating. */
+	static const FName GeneratedTag;
+
+private:
+	struct FTraversal
+	{
+		TWeakObjectPtr<class AlostandfoundCharacter> character;
+		float startTime;
+		bool leftGround;
+		bool wasWallrunning;
+		bool jumpedOff;
+	};
+
+	UFUNCTION()
+	void onSmartLinkReached(AActor* agent, const FVector& destination);
+
+	/* Launch the character into the move of the link. */
+	void startTraversal(class AlostandfoundCharacter* character) const;
+
+	/* Walljump at the end of the wallrun, true once the character is back on the ground or timed out. */
+	bool updateTraversal(FTraversal& traversal) const;
+
+	TArray<FTraversal> mTraversals;
+};
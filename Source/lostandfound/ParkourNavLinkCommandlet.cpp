@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ParkourNavLinkCommandlet.h"
+#include "ParkourNavLinkGenerator.h"
+#include "EngineUtils.h"
+#include "NavigationSystem.h"
+#include "Misc/PackageName.h"
+#include "UObject/SavePackage.h"
+#include "UObject/UObjectIterator.h"
+#include "WorldPartition/WorldPartition.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogParkourNavLink, Log, All);
+
+UParkourNavLinkCommandlet::UParkourNavLinkCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UParkourNavLinkCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	FString mapName;
+	if (FParse::Value(*Params, TEXT("map="), mapName) == false) {
+		UE_LOG(LogParkourNavLink, Error, TEXT("missing -map=<package name>"));
+		return 1;
+	}
+
+	UPackage* package = LoadPackage(nullptr, *mapName, LOAD_None);
+	UWorld* world = package ? UWorld::FindWorldInPackage(package) : nullptr;
+	if (world == nullptr) {
+		UE_LOG(LogParkourNavLink, Error, TEXT("could not load map %s"), *mapName);
+		return 1;
+	}
+
+	world->WorldType = EWorldType::Editor;
+	world->AddToRoot();
+	if (world->bIsWorldInitialized == false) {
+		UWorld::InitializationValues initValues;
+		initValues.RequiresHitProxies(false).ShouldSimulatePhysics(false).EnableTraceCollision(true).CreateNavigation(true).AllowAudioPlayback(false).CreateFXSystem(false);
+		world->InitWorld(initValues);
+	}
+	world->UpdateWorldComponents(true, false);
+
+	// world partition levels only have their always loaded actors resident, the links need all geometry
+	if (UWorldPartition* worldPartition = world->GetWorldPartition()) {
+		worldPartition->LoadEditorCells(FBox(FVector(-HALF_WORLD_MAX), FVector(HALF_WORLD_MAX)), false);
+	}
+
+	UNavigationSystemV1* navSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(world);
+	if (navSys == nullptr) {
+		UE_LOG(LogParkourNavLink, Error, TEXT("map %s has no navigation system"), *mapName);
+		return 1;
+	}
+	navSys->Build();
+
+	int32 generators = 0;
+	for (TActorIterator<AParkourNavLinkGenerator> it(world); it; ++it) {
+		it->generateLinks();
+		UE_LOG(LogParkourNavLink, Display, TEXT("%s: generated %d links"), *it->GetName(), it->mGeneratedLinks);
+		generators++;
+	}
+
+	if (generators == 0) {
+		UE_LOG(LogParkourNavLink, Warning, TEXT("map %s has no AParkourNavLinkGenerator"), *mapName);
+		return 0;
+	}
+
+	// the map and the external actor packages of the links
+	for (TObjectIterator<UPackage> it; it; ++it) {
+		UPackage* dirty = *it;
+		if (dirty->IsDirty() == false || dirty == GetTransientPackage() || dirty->HasAnyPackageFlags(PKG_CompiledIn)) {
+			continue;
+		}
+
+		UWorld* packageWorld = UWorld::FindWorldInPackage(dirty);
+		FString const extension = packageWorld ? FPackageName::GetMapPackageExtension() : FPackageName::GetAssetPackageExtension();
+		FString const filename = FPackageName::LongPackageNameToFilename(dirty->GetName(), extension);
+
+		FSavePackageArgs saveArgs;
+		saveArgs.TopLevelFlags = RF_Standalone;
+		if (UPackage::SavePackage(dirty, packageWorld, *filename, saveArgs) == false) {
+			UE_LOG(LogParkourNavLink, Error, TEXT("failed to save %s"), *filename);
+			return 1;
+		}
+	}
+
+	world->RemoveFromRoot();
+	return 0;
+#else
+	return 1;
+#endif
+}
@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ParkourNavLinkCommandlet.generated.h"
+
+/*
+ * Regenerates the parkour nav links of every AParkourNavLinkGenerator in a map and saves it.
+ * Usage: UnrealEditor-Cmd lostandfound.uproject -run=ParkourNavLink -map=/Game/ThirdPerson/Maps/ThirdPersonMap
+ */
+UCLASS()
+class UParkourNavLinkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UParkourNavLinkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
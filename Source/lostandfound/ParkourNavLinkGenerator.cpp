@@ -0,0 +1,219 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ParkourNavLinkGenerator.h"
+#include "lostandfoundCharacter.h"
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "NavigationSystem.h"
+#include "NavigationPath.h"
+#include "EngineUtils.h"
+
+AParkourNavLinkGenerator::AParkourNavLinkGenerator()
+{
+	mBounds = CreateDefaultSubobject<UBoxComponent>(TEXT("Bounds"));
+	mBounds->SetBoxExtent(FVector(2000.0f, 2000.0f, 500.0f));
+	mBounds->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	RootComponent = mBounds;
+
+	mCharacterClass = AlostandfoundCharacter::StaticClass();
+}
+
+void AParkourNavLinkGenerator::clearLinks()
+{
+	FBox const bounds = mBounds->Bounds.GetBox();
+	for (TActorIterator<AParkourNavLink> it(GetWorld()); it; ++it) {
+		if (it->ActorHasTag(AParkourNavLink::GeneratedTag) && bounds.IsInside(it->GetActorLocation())) {
+			it->Destroy();
+		}
+	}
+	mGeneratedLinks = 0;
+}
+
+void AParkourNavLinkGenerator::generateLinks()
+{
+	clearLinks();
+
+	UWorld* world = GetWorld();
+	UNavigationSystemV1* navSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(world);
+	if (navSys == nullptr || mCharacterClass == nullptr) {
+		return;
+	}
+
+	FBox const bounds = mBounds->Bounds.GetBox();
+
+	// transient character to run the movement physics with, spawned above the sampled geometry
+	FActorSpawnParameters spawnParams;
+	spawnParams.ObjectFlags |= RF_Transient;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	AlostandfoundCharacter* character = world->SpawnActor<AlostandfoundCharacter>(mCharacterClass, bounds.Max + FVector(0.0f, 0.0f, 10000.0f), FRotator::ZeroRotator, spawnParams);
+	if (character == nullptr) {
+		return;
+	}
+	character->SetActorEnableCollision(false);
+
+	USpecialMovementComponent* moves = character->GetSpecialMoves();
+	moves->Init(character, character->GetFollowCamera(), character->GetCameraBoom());
+	UCharacterMovementComponent* move = character->GetCharacterMovement();
+
+	float const entrySpeed = move->MaxWalkSpeed;
+	float const halfHeight = character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	float const radius = character->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	FCollisionQueryParams const params(SCENE_QUERY_STAT(ParkourNavLinkGenerator), true, character);
+
+	TArray<FLinkCandidate> candidates;
+	TArray<FLaunchQuery> queries;
+
+	for (float x = bounds.Min.X; x <= bounds.Max.X; x += mSampleSpacing) {
+		for (float y = bounds.Min.Y; y <= bounds.Max.Y; y += mSampleSpacing) {
+			FNavLocation ground;
+			FVector const queryExtent(mSampleSpacing * 0.5f, mSampleSpacing * 0.5f, bounds.GetExtent().Z);
+			if (navSys->ProjectPointToNavigation(FVector(x, y, bounds.GetCenter().Z), ground, queryExtent) == false) {
+				continue;
+			}
+
+			FVector const center = ground.Location + FVector(0.0f, 0.0f, halfHeight);
+			for (int32 i = 0; i < 8; i++) {
+				FVector const dir = FRotator(0.0f, i * 45.0f, 0.0f).Vector();
+
+				// walls close by: wallrun along them and jump off at the end
+				FHitResult wallHit;
+				if (world->LineTraceSingleByChannel(wallHit, center, center + dir * mMaxWallDistance, ECollisionChannel::ECC_WorldStatic, params) &&
+					moves->surfaceIsWallrunPossible(wallHit.ImpactNormal)) {
+
+					for (ESpecialMovementState side : { ESpecialMovementState::WALLRUN_LEFT, ESpecialMovementState::WALLRUN_RIGHT }) {
+						FLaunchQuery launch;
+						if (simulateWallrun(moves, wallHit, side, entrySpeed, launch)) {
+							candidates.Add({ ground.Location, EParkourLinkType::WALLJUMP, side, entrySpeed, USpecialMovementComponent::calcWallrunDir(wallHit.ImpactNormal, side) });
+							queries.Add(launch);
+						}
+					}
+				}
+
+				// edges close by: same probe as the jump boost in USpecialMovementComponent
+				FVector const edgeProbe = center + dir * radius * 2.5f;
+				FHitResult floorHit;
+				if (world->LineTraceSingleByChannel(floorHit, edgeProbe, edgeProbe - FVector(0.0f, 0.0f, halfHeight + move->MaxStepHeight * 2.0f), ECollisionChannel::ECC_WorldStatic, params) == false) {
+					FLaunchQuery launch;
+					launch.location = center;
+					launch.velocity = dir * entrySpeed;
+					launch.inputDir = dir;
+					launch.jumpBoost = true;
+
+					candidates.Add({ ground.Location, EParkourLinkType::JUMP_BOOST, ESpecialMovementState::NONE, entrySpeed, dir });
+					queries.Add(launch);
+				}
+			}
+		}
+	}
+
+	TArray<FLaunchArcPrediction> arcs;
+	moves->predictLaunchArcs(queries, arcs);
+	float const walkableFloorZ = move->GetWalkableFloorZ();
+
+	character->Destroy();
+
+	TArray<TPair<FVector, FVector>> accepted;
+	for (int32 i = 0; i < arcs.Num(); i++) {
+		FLaunchArcPrediction const & arc = arcs[i];
+		FLinkCandidate const & candidate = candidates[i];
+		if (arc.hit == false || arc.landingHit.ImpactNormal.Z < walkableFloorZ) {
+			continue;
+		}
+
+		FNavLocation landing;
+		if (navSys->ProjectPointToNavigation(arc.landingHit.Location - FVector(0.0f, 0.0f, halfHeight), landing) == false) {
+			continue;
+		}
+
+		if (isShortcut(candidate.start, landing.Location) == false) {
+			continue;
+		}
+
+		float const mergeDistSq = mMergeDistance * mMergeDistance;
+		bool const duplicate = accepted.ContainsByPredicate([&](TPair<FVector, FVector> const & link) {
+			return FVector::DistSquared(link.Key, candidate.start) < mergeDistSq && FVector::DistSquared(link.Value, landing.Location) < mergeDistSq;
+		});
+		if (duplicate) {
+			continue;
+		}
+		accepted.Emplace(candidate.start, landing.Location);
+
+		// store the links in the level of the generator
+		FActorSpawnParameters linkParams;
+		linkParams.OverrideLevel = GetLevel();
+		AParkourNavLink* link = world->SpawnActor<AParkourNavLink>(candidate.start, FRotator::ZeroRotator, linkParams);
+		if (link) {
+			link->setLink(landing.Location, candidate.type, candidate.state, candidate.entrySpeed, candidate.entryDirection);
+		}
+	}
+
+	mGeneratedLinks = accepted.Num();
+}
+
+bool AParkourNavLinkGenerator::simulateWallrun(USpecialMovementComponent* moves, FHitResult const & wallHit, ESpecialMovementState side, float entrySpeed, FLaunchQuery& outLaunch) const
+{
+	UWorld* world = GetWorld();
+	ACharacter* character = Cast<ACharacter>(moves->GetOwner());
+	float const radius = character->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	FCollisionShape const capsule = character->GetCapsuleComponent()->GetCollisionShape();
+	float const gravityZ = world->GetGravityZ() * moves->mWallrunGravity;
+	FCollisionQueryParams const params(SCENE_QUERY_STAT(ParkourNavLinkGenerator), true, character);
+
+	// same distance to the wall as the wallrun position correction
+	FVector normal = wallHit.ImpactNormal;
+	FVector position = wallHit.ImpactPoint + normal * radius * 1.2f;
+	FVector dir = USpecialMovementComponent::calcWallrunDir(normal, side);
+	// the character claws into the wall, start without vertical velocity
+	float velocityZ = 0.0f;
+
+	float time = 0.0f;
+	while (time < mMaxWallrunTime) {
+		velocityZ += gravityZ * mSimulationStep;
+		FVector next = position + (dir * entrySpeed + FVector(0.0f, 0.0f, velocityZ)) * mSimulationStep;
+
+		// hit the ground or blocking geometry
+		FHitResult hit;
+		if (world->SweepSingleByChannel(hit, position, next, FQuat::Identity, ECollisionChannel::ECC_WorldStatic, capsule, params)) {
+			break;
+		}
+
+		// follow the wall like updateWallrun does
+		FHitResult wall;
+		if (world->LineTraceSingleByChannel(wall, next, next - normal * radius * 2.0f, ECollisionChannel::ECC_WorldStatic, params) == false ||
+			moves->surfaceIsWallrunPossible(wall.ImpactNormal) == false) {
+			break;
+		}
+
+		normal = wall.ImpactNormal;
+		dir = USpecialMovementComponent::calcWallrunDir(normal, side);
+		FVector const corrected = wall.ImpactPoint + normal * radius * 1.2f;
+		position = FVector(corrected.X, corrected.Y, next.Z);
+		time += mSimulationStep;
+	}
+
+	// too short to count as a wallrun
+	if (time < mSimulationStep * 5.0f) {
+		return false;
+	}
+
+	outLaunch = FLaunchQuery();
+	outLaunch.location = position;
+	outLaunch.velocity = dir * entrySpeed + FVector(0.0f, 0.0f, velocityZ);
+	outLaunch.state = side;
+	outLaunch.wallNormal = normal;
+	outLaunch.inputDir = normal;
+	outLaunch.isFalling = true;
+	return true;
+}
+
+bool AParkourNavLinkGenerator::isShortcut(FVector const & start, FVector const & end) const
+{
+	UNavigationPath* path = UNavigationSystemV1::FindPathToLocationSynchronously(GetWorld(), start, end);
+	if (path == nullptr || path->IsValid() == false || path->IsPartial()) {
+		// not reachable by walking at all
+		return true;
+	}
+
+	return path->GetPathLength() >= FVector::Dist(start, end) * mMinShortcutRatio;
+}
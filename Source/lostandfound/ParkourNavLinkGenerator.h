@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ParkourNavLink.h"
+#include "ParkourNavLinkGenerator.generated.h"
+
+class AlostandfoundCharacter;
+
+/*
+ * Offline generation of parkour nav links inside the bounds of this actor.
+ * Wallruns and jump boosts are simulated with the USpecialMovementComponent physics of mCharacterClass,
+ * every move that lands on the navmesh becomes an AParkourNavLink stored in the level.
+ * Run it with the "Generate Links" button or for a whole map with the ParkourNavLink commandlet.
+ */
+UCLASS()
+class LOSTANDFOUND_API AParkourNavLinkGenerator : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AParkourNavLinkGenerator();
+
+	UFUNCTION(CallInEditor, Category = Generation)
+	void generateLinks();
+
+	UFUNCTION(CallInEditor, Category = Generation)
+	void clearLinks();
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Generation)
+	class UBoxComponent* mBounds;
+
+	/* Character whose movement settings are simulated. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Generation)
+	TSubclassOf<AlostandfoundCharacter> mCharacterClass;
+
+	/* Distance between sampled navmesh points. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Generation, meta = (ClampMin = "50.0", UIMin = "50.0"))
+	float mSampleSpacing = 200.0f;
+
+	/* Maximum distance from a navmesh point to a wall to start a wallrun. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Generation, meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float mMaxWallDistance = 300.0f;
+
+	/* Maximum simulated wallrun duration before jumping off. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Generation, meta = (ClampMin = "0.1", UIMin = "0.1"))
+	float mMaxWallrunTime = 1.5f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Generation, meta = (ClampMin = "0.005", UIMin = "0.005"))
+	float mSimulationStep = 0.02f;
+
+	/* Only keep links that are at least this much shorter than walking on the navmesh. 1.0 keeps all links. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Generation, meta = (ClampMin = "1.0", UIMin = "1.0"))
+	float mMinShortcutRatio = 1.5f;
+
+	/* Links with start and end closer than this to an existing link are dropped. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Generation, meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float mMergeDistance = 150.0f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Status)
+	int32 mGeneratedLinks = 0;
+
+private:
+	struct FLinkCandidate
+	{
+		FVector start;
+		EParkourLinkType type;
+		ESpecialMovementState state;
+		float entrySpeed;
+		FVector entryDirection;
+	};
+
+	bool simulateWallrun(class USpecialMovementComponent* moves, FHitResult const & wallHit, ESpecialMovementState side, float entrySpeed, FLaunchQuery& outLaunch) const;
+	bool isShortcut(FVector const & start, FVector const & end) const;
+};
@@ -0,0 +1,409 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ParkourPoseDatabase.h"
+#include "Animation/AnimSequence.h"
+#include "Animation/AttributesRuntime.h"
+#include "BonePose.h"
+
+void FParkourPoseFeatures::setVelocity(FVector const & velocity)
+{
+	values[VelocityOffset + 0] = velocity.X;
+	values[VelocityOffset + 1] = velocity.Y;
+	values[VelocityOffset + 2] = velocity.Z;
+}
+
+void FParkourPoseFeatures::setTrajectoryPoint(int32 index, FVector2D const & position)
+{
+	values[TrajectoryOffset + index * 2 + 0] = position.X;
+	values[TrajectoryOffset + index * 2 + 1] = position.Y;
+}
+
+void FParkourPoseFeatures::setFeet(FVector const & left, FVector const & right)
+{
+	values[PoseOffset + 0] = left.X;
+	values[PoseOffset + 1] = left.Y;
+	values[PoseOffset + 2] = left.Z;
+	values[PoseOffset + 3] = right.X;
+	values[PoseOffset + 4] = right.Y;
+	values[PoseOffset + 5] = right.Z;
+}
+
+float UParkourPoseDatabase::getBakedWeight(int32 index) const
+{
+	return index < FParkourPoseFeatures::TrajectoryOffset ? mBakedVelocityWeight : (index < FParkourPoseFeatures::PoseOffset ? mBakedTrajectoryWeight : mBakedPoseWeight);
+}
+
+void UParkourPoseDatabase::weightFeatures(float* values) const
+{
+	for (int32 i = 0; i < FParkourPoseFeatures::Dim; i++) {
+		values[i] *= getBakedWeight(i);
+	}
+}
+
+void UParkourPoseDatabase::project(float const* weighted, float* outProjected) const
+{
+	for (int32 k = 0; k < mBakedPcaDimensions; k++) {
+		float const* axis = &mPcaBasis[k * FParkourPoseFeatures::Dim];
+		float sum = 0.0f;
+		for (int32 i = 0; i < FParkourPoseFeatures::Dim; i++) {
+			sum += (weighted[i] - mFeatureMean[i]) * axis[i];
+		}
+		outProjected[k] = sum;
+	}
+}
+
+bool UParkourPoseDatabase::search(FParkourPoseFeatures const & query, ESpecialMovementState state, int32 maxLeaves, FParkourPoseMatch& outMatch) const
+{
+	int32 const root = mStateRoots.IsValidIndex((int32)state) ? mStateRoots[(int32)state] : INDEX_NONE;
+	if (root == INDEX_NONE) {
+		return false;
+	}
+
+	float weighted[FParkourPoseFeatures::Dim];
+	FMemory::Memcpy(weighted, query.values, sizeof(weighted));
+	weightFeatures(weighted);
+
+	float projected[FParkourPoseFeatures::Dim];
+	project(weighted, projected);
+
+	// depth first, near side first. The PCA projection is orthonormal, so the distance to a split plane
+	// is a lower bound of the full feature cost and far sides can be skipped early.
+	struct FStackEntry
+	{
+		int32 node;
+		float bound;
+	};
+	FStackEntry stack[64];
+	int32 stackSize = 0;
+	stack[stackSize++] = { root, 0.0f };
+
+	float bestCost = MAX_flt;
+	int32 bestPose = INDEX_NONE;
+	int32 leaves = 0;
+
+	while (stackSize > 0 && leaves < maxLeaves) {
+		FStackEntry const entry = stack[--stackSize];
+		if (entry.bound >= bestCost) {
+			continue;
+		}
+
+		FParkourKDNode const & node = mNodes[entry.node];
+		if (node.axis == INDEX_NONE) {
+			leaves++;
+			for (int32 i = node.first; i < node.first + node.count; i++) {
+				int32 const pose = mNodeOrder[i];
+				float const* features = &mFeatures[pose * FParkourPoseFeatures::Dim];
+				float cost = 0.0f;
+				for (int32 d = 0; d < FParkourPoseFeatures::Dim; d++) {
+					cost += FMath::Square(weighted[d] - features[d]);
+				}
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestPose = pose;
+				}
+			}
+			continue;
+		}
+
+		float const diff = projected[node.axis] - node.split;
+		int32 const nearChild = diff < 0.0f ? node.left : node.right;
+		int32 const farChild = diff < 0.0f ? node.right : node.left;
+		if (stackSize + 2 <= UE_ARRAY_COUNT(stack)) {
+			stack[stackSize++] = { farChild, FMath::Max(entry.bound, diff * diff) };
+			stack[stackSize++] = { nearChild, entry.bound };
+		}
+	}
+
+	if (bestPose == INDEX_NONE) {
+		return false;
+	}
+
+	FParkourPose const & pose = mPoses[bestPose];
+	outMatch.pose = bestPose;
+	outMatch.source = pose.source;
+	outMatch.sequence = mSources.IsValidIndex(pose.source) ? mSources[pose.source].sequence : nullptr;
+	outMatch.time = pose.time;
+	outMatch.cost = bestCost;
+	return outMatch.sequence != nullptr;
+}
+
+int32 UParkourPoseDatabase::findPose(int32 source, float time) const
+{
+	if (mSourceFirstPose.IsValidIndex(source) == false || mSourceFirstPose[source] == INDEX_NONE) {
+		return INDEX_NONE;
+	}
+
+	int32 const first = mSourceFirstPose[source];
+	int32 end = mPoses.Num();
+	for (int32 i = source + 1; i < mSourceFirstPose.Num(); i++) {
+		if (mSourceFirstPose[i] != INDEX_NONE) {
+			end = mSourceFirstPose[i];
+			break;
+		}
+	}
+
+	// poses of a source are sampled at a fixed interval
+	int32 index = FMath::RoundToInt(time / mSampleInterval);
+	if (mSources[source].loop) {
+		index %= (end - first);
+	}
+	return first + FMath::Clamp(index, 0, end - first - 1);
+}
+
+float UParkourPoseDatabase::calcCost(FParkourPoseFeatures const & query, int32 pose) const
+{
+	float weighted[FParkourPoseFeatures::Dim];
+	FMemory::Memcpy(weighted, query.values, sizeof(weighted));
+	weightFeatures(weighted);
+
+	float const* features = &mFeatures[pose * FParkourPoseFeatures::Dim];
+	float cost = 0.0f;
+	for (int32 d = 0; d < FParkourPoseFeatures::Dim; d++) {
+		cost += FMath::Square(weighted[d] - features[d]);
+	}
+	return cost;
+}
+
+void UParkourPoseDatabase::getPoseFeatures(int32 pose, FParkourPoseFeatures& outFeatures) const
+{
+	float const* features = &mFeatures[pose * FParkourPoseFeatures::Dim];
+	for (int32 i = 0; i < FParkourPoseFeatures::Dim; i++) {
+		float const weight = getBakedWeight(i);
+		outFeatures.values[i] = weight > 0.0f ? features[i] / weight : 0.0f;
+	}
+}
+
+#if WITH_EDITOR
+
+void UParkourPoseDatabase::bake()
+{
+	mPoses.Reset();
+	mFeatures.Reset();
+	mSourceFirstPose.Init(INDEX_NONE, mSources.Num());
+
+	mBakedVelocityWeight = mVelocityWeight;
+	mBakedTrajectoryWeight = mTrajectoryWeight;
+	mBakedPoseWeight = mPoseWeight;
+
+	for (int32 i = 0; i < mSources.Num(); i++) {
+		sampleSource(i);
+	}
+	mNumPoses = mPoses.Num();
+
+	computePca();
+
+	// one tree per state over the projected poses
+	mNodes.Reset();
+	mNodeOrder.Reset(mPoses.Num());
+	mStateRoots.Init(INDEX_NONE, SpecialMovementTransitions::NumStates);
+	for (int32 state = 0; state < SpecialMovementTransitions::NumStates; state++) {
+		int32 const first = mNodeOrder.Num();
+		for (int32 pose = 0; pose < mPoses.Num(); pose++) {
+			if ((int32)mSources[mPoses[pose].source].state == state) {
+				mNodeOrder.Add(pose);
+			}
+		}
+		if (mNodeOrder.Num() > first) {
+			mStateRoots[state] = buildTree(first, mNodeOrder.Num() - first);
+		}
+	}
+
+	MarkPackageDirty();
+}
+
+bool UParkourPoseDatabase::sampleSource(int32 sourceIndex)
+{
+	FParkourPoseSource const & source = mSources[sourceIndex];
+	UAnimSequence* sequence = source.sequence;
+	USkeleton* skeleton = sequence ? sequence->GetSkeleton() : nullptr;
+	if (skeleton == nullptr) {
+		return false;
+	}
+
+	int32 const leftFoot = skeleton->GetReferenceSkeleton().FindBoneIndex(mLeftFootBone);
+	int32 const rightFoot = skeleton->GetReferenceSkeleton().FindBoneIndex(mRightFootBone);
+	if (leftFoot == INDEX_NONE || rightFoot == INDEX_NONE) {
+		return false;
+	}
+
+	// the whole skeleton is required, component space foot positions depend on the full chain
+	TArray<FBoneIndexType> requiredBones;
+	for (int32 i = 0; i < skeleton->GetReferenceSkeleton().GetNum(); i++) {
+		requiredBones.Add((FBoneIndexType)i);
+	}
+	FBoneContainer boneContainer(requiredBones, FCurveEvaluationOption(false), *skeleton);
+	FCompactPoseBoneIndex const leftIndex = boneContainer.MakeCompactPoseIndex(FMeshPoseBoneIndex(leftFoot));
+	FCompactPoseBoneIndex const rightIndex = boneContainer.MakeCompactPoseIndex(FMeshPoseBoneIndex(rightFoot));
+
+	FCompactPose pose;
+	pose.SetBoneContainer(&boneContainer);
+	FBlendedCurve curve;
+	curve.InitFrom(boneContainer);
+	UE::Anim::FStackAttributeContainer attributes;
+	FAnimationPoseData poseData(pose, curve, attributes);
+
+	mSourceFirstPose[sourceIndex] = mPoses.Num();
+	float const length = sequence->GetPlayLength();
+	for (float time = 0.0f; time < length; time += mSampleInterval) {
+		FParkourPoseFeatures features;
+
+		if (sequence->HasRootMotion()) {
+			features.setVelocity(sequence->ExtractRootMotion(time, mSampleInterval, source.loop).GetTranslation() / mSampleInterval);
+			for (int32 i = 0; i < FParkourPoseFeatures::NumTrajectoryPoints; i++) {
+				features.setTrajectoryPoint(i, FVector2D(sequence->ExtractRootMotion(time, FParkourPoseFeatures::TrajectoryTimes[i], source.loop).GetTranslation()));
+			}
+		}
+		else {
+			features.setVelocity(source.inPlaceVelocity);
+			for (int32 i = 0; i < FParkourPoseFeatures::NumTrajectoryPoints; i++) {
+				features.setTrajectoryPoint(i, FVector2D(source.inPlaceVelocity * FParkourPoseFeatures::TrajectoryTimes[i]));
+			}
+		}
+
+		sequence->GetBonePose(poseData, FAnimExtractContext(time, false));
+		FCSPose<FCompactPose> componentPose;
+		componentPose.InitPose(pose);
+		features.setFeet(componentPose.GetComponentSpaceTransform(leftIndex).GetLocation(), componentPose.GetComponentSpaceTransform(rightIndex).GetLocation());
+
+		weightFeatures(features.values);
+		mFeatures.Append(features.values, FParkourPoseFeatures::Dim);
+		mPoses.Add({ sourceIndex, time });
+	}
+	return true;
+}
+
+void UParkourPoseDatabase::computePca()
+{
+	constexpr int32 Dim = FParkourPoseFeatures::Dim;
+	int32 const numPoses = mPoses.Num();
+	mBakedPcaDimensions = FMath::Clamp(mPcaDimensions, 1, Dim);
+
+	mFeatureMean.Init(0.0f, Dim);
+	for (int32 pose = 0; pose < numPoses; pose++) {
+		for (int32 i = 0; i < Dim; i++) {
+			mFeatureMean[i] += mFeatures[pose * Dim + i] / numPoses;
+		}
+	}
+
+	double covariance[Dim][Dim] = {};
+	for (int32 pose = 0; pose < numPoses; pose++) {
+		float const* features = &mFeatures[pose * Dim];
+		for (int32 i = 0; i < Dim; i++) {
+			for (int32 j = 0; j < Dim; j++) {
+				covariance[i][j] += (features[i] - mFeatureMean[i]) * (features[j] - mFeatureMean[j]);
+			}
+		}
+	}
+
+	// principal axes by power iteration. Every axis, including the fallback when no variance is left, is kept
+	// orthonormal to the previous ones: search relies on it to bound the cost by the distance to a split plane
+	double basis[Dim][Dim] = {};
+	auto orthonormalize = [&basis](double* vector, int32 numPrevious) {
+		for (int32 previous = 0; previous < numPrevious; previous++) {
+			double dot = 0.0;
+			for (int32 i = 0; i < Dim; i++) {
+				dot += vector[i] * basis[previous][i];
+			}
+			for (int32 i = 0; i < Dim; i++) {
+				vector[i] -= dot * basis[previous][i];
+			}
+		}
+
+		double length = 0.0;
+		for (int32 i = 0; i < Dim; i++) {
+			length += vector[i] * vector[i];
+		}
+		length = FMath::Sqrt(length);
+		if (length < DOUBLE_SMALL_NUMBER) {
+			return false;
+		}
+		for (int32 i = 0; i < Dim; i++) {
+			vector[i] /= length;
+		}
+		return true;
+	};
+
+	for (int32 k = 0; k < mBakedPcaDimensions; k++) {
+		// start from the first unit axis not spanned by the previous axes, there always is one while k < Dim
+		double* axis = basis[k];
+		for (int32 unit = 0; unit < Dim; unit++) {
+			FMemory::Memzero(axis, sizeof(double) * Dim);
+			axis[(k + unit) % Dim] = 1.0;
+			if (orthonormalize(axis, k)) {
+				break;
+			}
+		}
+
+		for (int32 iteration = 0; iteration < 64; iteration++) {
+			double next[Dim] = {};
+			for (int32 i = 0; i < Dim; i++) {
+				for (int32 j = 0; j < Dim; j++) {
+					next[i] += covariance[i][j] * axis[j];
+				}
+			}
+
+			if (orthonormalize(next, k) == false) {
+				// no variance left, keep the orthonormal start axis
+				break;
+			}
+			FMemory::Memcpy(axis, next, sizeof(next));
+		}
+	}
+
+	mPcaBasis.Init(0.0f, mBakedPcaDimensions * Dim);
+	for (int32 k = 0; k < mBakedPcaDimensions; k++) {
+		for (int32 i = 0; i < Dim; i++) {
+			mPcaBasis[k * Dim + i] = (float)basis[k][i];
+		}
+	}
+
+	mProjected.SetNumUninitialized(numPoses * mBakedPcaDimensions);
+	for (int32 pose = 0; pose < numPoses; pose++) {
+		project(&mFeatures[pose * Dim], &mProjected[pose * mBakedPcaDimensions]);
+	}
+}
+
+int32 UParkourPoseDatabase::buildTree(int32 first, int32 count)
+{
+	int32 const nodeIndex = mNodes.AddDefaulted();
+	if (count <= mLeafSize) {
+		mNodes[nodeIndex].first = first;
+		mNodes[nodeIndex].count = count;
+		return nodeIndex;
+	}
+
+	// split the axis with the largest spread at the median
+	int32 axis = 0;
+	float bestSpread = -1.0f;
+	for (int32 k = 0; k < mBakedPcaDimensions; k++) {
+		float minValue = MAX_flt;
+		float maxValue = -MAX_flt;
+		for (int32 i = first; i < first + count; i++) {
+			float const value = mProjected[mNodeOrder[i] * mBakedPcaDimensions + k];
+			minValue = FMath::Min(minValue, value);
+			maxValue = FMath::Max(maxValue, value);
+		}
+		if (maxValue - minValue > bestSpread) {
+			bestSpread = maxValue - minValue;
+			axis = k;
+		}
+	}
+
+	TArrayView<int32>(mNodeOrder.GetData() + first, count).Sort([this, axis](int32 a, int32 b) {
+		return mProjected[a * mBakedPcaDimensions + axis] < mProjected[b * mBakedPcaDimensions + axis];
+	});
+
+	int32 const half = count / 2;
+	float const split = mProjected[mNodeOrder[first + half] * mBakedPcaDimensions + axis];
+	int32 const left = buildTree(first, half);
+	int32 const right = buildTree(first + half, count - half);
+
+	FParkourKDNode& node = mNodes[nodeIndex];
+	node.axis = axis;
+	node.split = split;
+	node.left = left;
+	node.right = right;
+	return nodeIndex;
+}
+
+#endif
@@ -0,0 +1,212 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "SpecialMovementComponent.h"
+#include "ParkourPoseDatabase.generated.h"
+
+class UAnimSequence;
+
+/* Animation sampled into the pose database. */
+USTRUCT(BlueprintType)
+struct FParkourPoseSource
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Source)
+	UAnimSequence* sequence = nullptr;
+
+	/* Poses of this sequence only match queries in this state. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Source)
+	ESpecialMovementState state = ESpecialMovementState::NONE;
+
+	/* Mesh space velocity of in place animations. Sequences with root motion use their root motion instead. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Source)
+	FVector inPlaceVelocity = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Source)
+	bool loop = true;
+};
+
+/* Motion matching features of a pose or a query, in mesh space: velocity, future trajectory and foot positions. */
+struct FParkourPoseFeatures
+{
+	static constexpr int32 NumTrajectoryPoints = 2;
+	static constexpr float TrajectoryTimes[NumTrajectoryPoints] = { 0.25f, 0.5f };
+
+	static constexpr int32 VelocityOffset = 0;
+	static constexpr int32 TrajectoryOffset = 3;
+	static constexpr int32 PoseOffset = TrajectoryOffset + NumTrajectoryPoints * 2;
+	static constexpr int32 Dim = PoseOffset + 6;
+
+	float values[Dim] = {};
+
+	void setVelocity(FVector const & velocity);
+	void setTrajectoryPoint(int32 index, FVector2D const & position);
+	void setFeet(FVector const & left, FVector const & right);
+};
+
+USTRUCT()
+struct FParkourPose
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 source = 0;
+
+	UPROPERTY()
+	float time = 0.0f;
+};
+
+/* Node of the KD-tree over the PCA projected poses. Leaves reference a range of the node order. */
+USTRUCT()
+struct FParkourKDNode
+{
+	GENERATED_BODY()
+
+	/* Split axis in PCA space, INDEX_NONE for leaves. */
+	UPROPERTY()
+	int32 axis = INDEX_NONE;
+
+	UPROPERTY()
+	float split = 0.0f;
+
+	UPROPERTY()
+	int32 left = INDEX_NONE;
+
+	UPROPERTY()
+	int32 right = INDEX_NONE;
+
+	UPROPERTY()
+	int32 first = 0;
+
+	UPROPERTY()
+	int32 count = 0;
+};
+
+struct FParkourPoseMatch
+{
+	int32 pose = INDEX_NONE;
+	int32 source = INDEX_NONE;
+	UAnimSequence* sequence = nullptr;
+	float time = 0.0f;
+	float cost = MAX_flt;
+};
+
+/*
+ * Motion matching database for the special moves. The source sequences are sampled into feature vectors by bake,
+ * projected to mPcaDimensions with PCA and indexed by one KD-tree per ESpecialMovementState.
+ * A search visits at most maxLeaves leaves, which bounds its cost per character. Leaves are ranked with the full features.
+ */
+UCLASS(BlueprintType)
+class LOSTANDFOUND_API UParkourPoseDatabase : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Sources)
+	TArray<FParkourPoseSource> mSources;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Sources, meta = (ClampMin = "0.01", UIMin = "0.01"))
+	float mSampleInterval = 1.0f / 30.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Sources)
+	FName mLeftFootBone = TEXT("foot_l");
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Sources)
+	FName mRightFootBone = TEXT("foot_r");
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Weights, meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float mVelocityWeight = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Weights, meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float mTrajectoryWeight = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Weights, meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float mPoseWeight = 0.5f;
+
+	/* Dimensions the KD-tree is built on. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Index, meta = (ClampMin = "1", ClampMax = "13", UIMin = "1", UIMax = "13"))
+	int32 mPcaDimensions = 6;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Index, meta = (ClampMin = "1", UIMin = "1"))
+	int32 mLeafSize = 8;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Index)
+	int32 mNumPoses = 0;
+
+#if WITH_EDITOR
+	/* Sample all sources and rebuild the index. */
+	UFUNCTION(CallInEditor, Category = Sources)
+	void bake();
+#endif
+
+	/* Cheapest pose of the state for the query. Thread safe. */
+	bool search(FParkourPoseFeatures const & query, ESpecialMovementState state, int32 maxLeaves, FParkourPoseMatch& outMatch) const;
+
+	/* Pose of the source closest to the time, INDEX_NONE when the source was not baked. */
+	int32 findPose(int32 source, float time) const;
+
+	float calcCost(FParkourPoseFeatures const & query, int32 pose) const;
+
+	/* Unweighted features of a baked pose, the pose part is used for the next query. */
+	void getPoseFeatures(int32 pose, FParkourPoseFeatures& outFeatures) const;
+
+private:
+	UPROPERTY()
+	TArray<FParkourPose> mPoses;
+
+	// weighted features, Dim per pose
+	UPROPERTY()
+	TArray<float> mFeatures;
+
+	UPROPERTY()
+	TArray<float> mFeatureMean;
+
+	// mPcaDimensions rows of Dim
+	UPROPERTY()
+	TArray<float> mPcaBasis;
+
+	// mPcaDimensions per pose
+	UPROPERTY()
+	TArray<float> mProjected;
+
+	UPROPERTY()
+	TArray<FParkourKDNode> mNodes;
+
+	// pose indices, grouped by state and ordered by the tree
+	UPROPERTY()
+	TArray<int32> mNodeOrder;
+
+	// root node per ESpecialMovementState
+	UPROPERTY()
+	TArray<int32> mStateRoots;
+
+	UPROPERTY()
+	TArray<int32> mSourceFirstPose;
+
+	UPROPERTY()
+	int32 mBakedPcaDimensions = 0;
+
+	// the stored features carry the weights of the last bake, queries are weighted the same until the next one
+	UPROPERTY()
+	float mBakedVelocityWeight = 1.0f;
+
+	UPROPERTY()
+	float mBakedTrajectoryWeight = 1.0f;
+
+	UPROPERTY()
+	float mBakedPoseWeight = 0.5f;
+
+	float getBakedWeight(int32 index) const;
+	void weightFeatures(float* values) const;
+	void project(float const* weighted, float* outProjected) const;
+
+#if WITH_EDITOR
+	bool sampleSource(int32 sourceIndex);
+	void computePca();
+	int32 buildTree(int32 first, int32 count);
+#endif
+};
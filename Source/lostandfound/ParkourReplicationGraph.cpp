@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ParkourReplicationGraph.h"
+#include "lostandfoundCharacter.h"
+#include "SpecialMovementComponent.h"
+#include "Engine/NetConnection.h"
+
+void UParkourReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// per character periods are set at runtime, the class settings only hold for the first frames after spawning
+	FClassReplicationInfo characterInfo;
+	characterInfo.SetCullDistanceSquared(mCharacterCullDistance * mCharacterCullDistance);
+	characterInfo.ReplicationPeriodFrame = (uint16)mFastPeriod;
+	GlobalActorReplicationInfoMap.SetClassInfo(AlostandfoundCharacter::StaticClass(), characterInfo);
+}
+
+void UParkourReplicationGraph::InitGlobalGraphNodes()
+{
+	Super::InitGlobalGraphNodes();
+
+	GridNode->CellSize = mGridCellSize;
+}
+
+void UParkourReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	Super::RouteAddNetworkActorToNodes(ActorInfo, GlobalInfo);
+
+	if (AlostandfoundCharacter* character = Cast<AlostandfoundCharacter>(ActorInfo.Actor)) {
+		mCharacters.Add({ character, mFastPeriod });
+	}
+}
+
+void UParkourReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	Super::RouteRemoveNetworkActorToNodes(ActorInfo);
+
+	if (AlostandfoundCharacter* character = Cast<AlostandfoundCharacter>(ActorInfo.Actor)) {
+		mCharacters.RemoveAllSwap([character](FTrackedCharacter const & tracked) { return tracked.character == character; });
+	}
+}
+
+int32 UParkourReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	updateCharacterPeriods();
+
+	return Super::ServerReplicateActors(DeltaSeconds);
+}
+
+int32 UParkourReplicationGraph::calcStatePeriod(AlostandfoundCharacter const* character) const
+{
+	FSpecialMovementAnimSnapshot const & snapshot = character->GetSpecialMoves()->getAnimSnapshot();
+	float const speedSq = character->GetVelocity().SizeSquared();
+
+	switch (snapshot.state) {
+	case ESpecialMovementState::WALLRUN_LEFT:
+	case ESpecialMovementState::WALLRUN_RIGHT:
+	case ESpecialMovementState::WALLRUN_UP:
+	case ESpecialMovementState::SLIDE:
+	case ESpecialMovementState::LEDGE_PULL:
+		return mFastPeriod;
+	case ESpecialMovementState::ON_LEDGE:
+		return mIdlePeriod;
+	default:
+		break;
+	}
+
+	if (speedSq >= mFastSpeed * mFastSpeed) {
+		return mFastPeriod;
+	}
+	if (snapshot.isFalling || speedSq >= mIdleSpeed * mIdleSpeed) {
+		return mMovingPeriod;
+	}
+	return mIdlePeriod;
+}
+
+void UParkourReplicationGraph::updateCharacterPeriods()
+{
+	uint32 const frame = GetReplicationGraphFrame();
+
+	// the state period is cheap and checked every frame, a change is pushed to all connections right away
+	for (FTrackedCharacter& tracked : mCharacters) {
+		int32 const period = calcStatePeriod(tracked.character);
+		if (period == tracked.period) {
+			continue;
+		}
+
+		tracked.period = period;
+		GlobalActorReplicationInfoMap.Get(tracked.character).Settings.ReplicationPeriodFrame = (uint16)period;
+		applyConnectionPeriods(tracked, frame);
+	}
+
+	// viewers move all the time, refresh the distance scale of a slice of the characters per frame
+	int32 const num = mCharacters.Num();
+	int32 const slice = FMath::DivideAndRoundUp(num, mDistanceRefreshFrames);
+	for (int32 i = 0; i < slice && num > 0; i++) {
+		mDistanceRefreshCursor = (mDistanceRefreshCursor + 1) % num;
+		applyConnectionPeriods(mCharacters[mDistanceRefreshCursor], frame);
+	}
+}
+
+void UParkourReplicationGraph::applyConnectionPeriods(FTrackedCharacter const & tracked, uint32 frame)
+{
+	FVector const location = tracked.character->GetActorLocation();
+	float const farDistSq = mFarDistance * mFarDistance;
+
+	for (UNetReplicationGraphConnection* connection : Connections) {
+		// only connections that gathered the character from the grid have an entry
+		FConnectionReplicationActorInfo* info = connection->ActorInfoMap.Find(tracked.character);
+		if (info == nullptr) {
+			continue;
+		}
+
+		AActor const* viewTarget = connection->NetConnection ? connection->NetConnection->ViewTarget : nullptr;
+		bool const far = viewTarget && FVector::DistSquared(viewTarget->GetActorLocation(), location) > farDistSq;
+		int32 const period = far ? tracked.period * mFarPeriodScale : tracked.period;
+
+		info->ReplicationPeriodFrame = (uint16)FMath::Clamp(period, 1, (int32)MAX_uint16);
+		// a character speeding up is sent with the new period instead of waiting out the old, longer one
+		info->NextReplicationFrameNum = FMath::Min(info->NextReplicationFrameNum, frame + info->ReplicationPeriodFrame);
+	}
+}
@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BasicReplicationGraph.h"
+#include "ParkourReplicationGraph.generated.h"
+
+class AlostandfoundCharacter;
+class UNetReplicationGraphConnection;
+
+/*
+ * Server replication driver for large lobbies, set as ReplicationDriverClassName of the IpNetDriver in DefaultEngine.ini.
+ *
+ * Builds on the basic graph: characters and other movable actors live in a 2D spatial grid, so each connection only gathers the cells around its viewer
+ * instead of the whole actor list. On top of that every character gets a replication period from its special movement state:
+ * wallrunning and sliding characters replicate every frame, idle ones only every few frames, and both slow down further for viewers far away.
+ *
+ * Compare against the default net driver with the load harness (see ParkourLoadHarness.h) by starting the server with
+ * -ini:Engine:[/Script/OnlineSubsystemUtils.IpNetDriver]:ReplicationDriverClassName=
+ */
+UCLASS(transient, config=Game)
+class LOSTANDFOUND_API UParkourReplicationGraph : public UBasicReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+
+	/* Size of a spatial grid cell. Smaller cells gather fewer actors per connection but move actors between cells more often. */
+	UPROPERTY(config, EditAnywhere, Category = Replication, meta = (ClampMin = "1000.0"))
+	float mGridCellSize = 10000.0f;
+
+	/* Characters further away than this from a viewer are not replicated to it. */
+	UPROPERTY(config, EditAnywhere, Category = Replication, meta = (ClampMin = "0.0"))
+	float mCharacterCullDistance = 15000.0f;
+
+	/* Replication period in frames of wallrunning, sliding and ledge pulling characters or anything faster than mFastSpeed. */
+	UPROPERTY(config, EditAnywhere, Category = Replication, meta = (ClampMin = "1"))
+	int32 mFastPeriod = 1;
+
+	/* Replication period in frames of walking and falling characters. */
+	UPROPERTY(config, EditAnywhere, Category = Replication, meta = (ClampMin = "1"))
+	int32 mMovingPeriod = 2;
+
+	/* Replication period in frames of characters standing still or hanging on a ledge. */
+	UPROPERTY(config, EditAnywhere, Category = Replication, meta = (ClampMin = "1"))
+	int32 mIdlePeriod = 6;
+
+	/* Characters at least this fast use mFastPeriod whatever their state. */
+	UPROPERTY(config, EditAnywhere, Category = Replication, meta = (ClampMin = "0.0"))
+	float mFastSpeed = 1000.0f;
+
+	/* Characters slower than this on the ground are idle. */
+	UPROPERTY(config, EditAnywhere, Category = Replication, meta = (ClampMin = "0.0"))
+	float mIdleSpeed = 10.0f;
+
+	/* Viewers further away than this get the period multiplied by mFarPeriodScale. */
+	UPROPERTY(config, EditAnywhere, Category = Replication, meta = (ClampMin = "0.0"))
+	float mFarDistance = 5000.0f;
+
+	UPROPERTY(config, EditAnywhere, Category = Replication, meta = (ClampMin = "1"))
+	int32 mFarPeriodScale = 3;
+
+	/* Every character rechecks the distance to all viewers once in this many frames, a slice of the characters per frame. */
+	UPROPERTY(config, EditAnywhere, Category = Replication, meta = (ClampMin = "1"))
+	int32 mDistanceRefreshFrames = 8;
+
+private:
+	struct FTrackedCharacter
+	{
+		AlostandfoundCharacter* character;
+		int32 period;
+	};
+
+	int32 calcStatePeriod(AlostandfoundCharacter const* character) const;
+	void updateCharacterPeriods();
+	void applyConnectionPeriods(FTrackedCharacter const & tracked, uint32 frame);
+
+	TArray<FTrackedCharacter> mCharacters;
+	int32 mDistanceRefreshCursor = 0;
+};
@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ParkourRetargetCommandlet.h"
+#include "Animation/AnimBoneCompressionSettings.h"
+#include "Animation/AnimSequence.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Engine/SkeletalMesh.h"
+#include "Misc/PackageName.h"
+#include "UObject/SavePackage.h"
+
+#if WITH_EDITOR
+#include "RetargetEditor/IKRetargetBatchOperation.h"
+#include "Retargeter/IKRetargeter.h"
+#endif
+
+DEFINE_LOG_CATEGORY_STATIC(LogParkourRetarget, Log, All);
+
+UParkourRetargetCommandlet::UParkourRetargetCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UParkourRetargetCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	FString sourcePath;
+	if (FParse::Value(*Params, TEXT("source="), sourcePath) == false) {
+		UE_LOG(LogParkourRetarget, Error, TEXT("missing -source=<content path>"));
+		return 1;
+	}
+
+	FString retargeterName = TEXT("/Game/Mixamo/IKRTG_Mixamo_UE5.IKRTG_Mixamo_UE5");
+	FString sourceMeshName = TEXT("/Game/Mixamo/Beta_HighLimbsGeoSG2.Beta_HighLimbsGeoSG2");
+	FString targetMeshName = TEXT("/Game/Characters/Mannequins/Meshes/SK_Mannequin.SK_Mannequin");
+	FString codecName;
+	FString suffix = TEXT("_Baked");
+	FParse::Value(*Params, TEXT("retargeter="), retargeterName);
+	FParse::Value(*Params, TEXT("sourceMesh="), sourceMeshName);
+	FParse::Value(*Params, TEXT("targetMesh="), targetMeshName);
+	FParse::Value(*Params, TEXT("codec="), codecName);
+	FParse::Value(*Params, TEXT("suffix="), suffix);
+
+	UIKRetargeter* retargeter = LoadObject<UIKRetargeter>(nullptr, *retargeterName);
+	USkeletalMesh* sourceMesh = LoadObject<USkeletalMesh>(nullptr, *sourceMeshName);
+	USkeletalMesh* targetMesh = LoadObject<USkeletalMesh>(nullptr, *targetMeshName);
+	if (retargeter == nullptr || sourceMesh == nullptr || targetMesh == nullptr) {
+		UE_LOG(LogParkourRetarget, Error, TEXT("could not load retargeter %s, source mesh %s or target mesh %s"), *retargeterName, *sourceMeshName, *targetMeshName);
+		return 1;
+	}
+
+	UAnimBoneCompressionSettings* codec = nullptr;
+	if (codecName.IsEmpty() == false) {
+		codec = LoadObject<UAnimBoneCompressionSettings>(nullptr, *codecName);
+		if (codec == nullptr) {
+			UE_LOG(LogParkourRetarget, Error, TEXT("could not load compression settings %s"), *codecName);
+			return 1;
+		}
+	}
+
+	IAssetRegistry& assetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	assetRegistry.SearchAllAssets(true);
+
+	FARFilter filter;
+	filter.PackagePaths.Add(*sourcePath);
+	filter.ClassNames.Add(UAnimSequence::StaticClass()->GetFName());
+	filter.bRecursivePaths = true;
+	TArray<FAssetData> sequences;
+	assetRegistry.GetAssets(filter, sequences);
+
+	// only the clips authored on the Mixamo skeleton, everything else is native already
+	FString const skeletonTag = FAssetData(sourceMesh->GetSkeleton()).GetExportTextName();
+	sequences.RemoveAll([&](FAssetData const & asset) {
+		return asset.GetTagValueRef<FString>(TEXT("Skeleton")) != skeletonTag ||
+			asset.AssetName.ToString().EndsWith(suffix);
+	});
+
+	if (sequences.Num() == 0) {
+		UE_LOG(LogParkourRetarget, Warning, TEXT("no sequences on skeleton %s below %s"), *sourceMesh->GetSkeleton()->GetName(), *sourcePath);
+		return 0;
+	}
+
+	// duplicates every sequence next to the original and bakes the retargeted pose of each frame into it
+	TArray<FAssetData> const baked = UIKRetargetBatchOperation::DuplicateAndRetarget(sequences, sourceMesh, targetMesh, retargeter, FString(), FString(), FString(), suffix, false);
+
+	for (FAssetData const & asset : baked) {
+		UAnimSequence* sequence = Cast<UAnimSequence>(asset.GetAsset());
+		if (sequence == nullptr) {
+			continue;
+		}
+
+		if (codec) {
+			sequence->BoneCompressionSettings = codec;
+		}
+		sequence->RequestSyncAnimRecompression(false);
+
+		UPackage* package = sequence->GetOutermost();
+		FString const filename = FPackageName::LongPackageNameToFilename(package->GetName(), FPackageName::GetAssetPackageExtension());
+
+		FSavePackageArgs saveArgs;
+		saveArgs.TopLevelFlags = RF_Standalone;
+		if (UPackage::SavePackage(package, nullptr, *filename, saveArgs) == false) {
+			UE_LOG(LogParkourRetarget, Error, TEXT("failed to save %s"), *filename);
+			return 1;
+		}
+
+		UE_LOG(LogParkourRetarget, Display, TEXT("baked %s"), *package->GetName());
+	}
+
+	return 0;
+#else
+	return 1;
+#endif
+}
@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ParkourRetargetCommandlet.generated.h"
+
+/*
+ * Bakes the Mixamo animations into native Mannequin sequences, so no retarget node has to run at runtime.
+ * Every UAnimSequence below -source= that uses the skeleton of the Mixamo mesh is retargeted with the IK retargeter
+ * and saved next to the original with -suffix= appended. The baked sequences get the compression settings of -codec=.
+ *
+ * Usage: UnrealEditor-Cmd lostandfound.uproject -run=ParkourRetarget -source=/Game/Mixamo
+ *        [-retargeter=/Game/Mixamo/IKRTG_Mixamo_UE5] [-sourceMesh=/Game/Mixamo/Beta_HighLimbsGeoSG2]
+ *        [-targetMesh=/Game/Characters/Mannequins/Meshes/SK_Mannequin] [-codec=<UAnimBoneCompressionSettings>] [-suffix=_Baked]
+ */
+UCLASS()
+class UParkourRetargetCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UParkourRetargetCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ParkourSignificance.h"
+#include "lostandfoundCharacter.h"
+#include "SignificanceManager.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+
+const FName UParkourSignificanceSubsystem::Tag(TEXT("ParkourCharacter"));
+
+void UParkourSignificanceSubsystem::registerCharacter(AlostandfoundCharacter* character)
+{
+	USignificanceManager* manager = USignificanceManager::Get(GetWorld());
+	if (manager == nullptr) {
+		return;
+	}
+
+	auto significance = [this](USignificanceManager::FManagedObjectInfo* info, FTransform const & viewpoint) {
+		return (float)calcSignificance(CastChecked<AlostandfoundCharacter>(info->GetObject()), viewpoint);
+	};
+
+	// sequential post significance, the buckets change tick settings which has to happen on the game thread.
+	// Update calls it for every object each frame, final is only set when the object is unregistered
+	auto postSignificance = [](USignificanceManager::FManagedObjectInfo* info, float oldSignificance, float significance, bool final) {
+		AlostandfoundCharacter* character = CastChecked<AlostandfoundCharacter>(info->GetObject());
+		if (final) {
+			// leaving the manager, e.g. into the pool: back to the full rate defaults
+			character->applySignificance(EParkourSignificance::HIGH);
+		}
+		else if (oldSignificance != significance) {
+			character->applySignificance((EParkourSignificance)(uint8)significance);
+		}
+	};
+
+	manager->RegisterObject(character, Tag, significance, USignificanceManager::EPostSignificanceType::Sequential, postSignificance);
+
+	// the callback only fires on changes, start from the bucket of the current viewpoints
+	character->applySignificance(calcInitialSignificance(character));
+}
+
+void UParkourSignificanceSubsystem::unregisterCharacter(AlostandfoundCharacter* character)
+{
+	if (USignificanceManager* manager = USignificanceManager::Get(GetWorld())) {
+		manager->UnregisterObject(character);
+	}
+}
+
+void UParkourSignificanceSubsystem::Tick(float DeltaTime)
+{
+	USignificanceManager* manager = USignificanceManager::Get(GetWorld());
+	if (manager == nullptr) {
+		return;
+	}
+
+	// local players on clients, every connected player on a server
+	mViewpoints.Reset();
+	for (FConstPlayerControllerIterator it = GetWorld()->GetPlayerControllerIterator(); it; ++it) {
+		APlayerController* controller = it->Get();
+		if (controller == nullptr) {
+			continue;
+		}
+
+		FVector location;
+		FRotator rotation;
+		controller->GetPlayerViewPoint(location, rotation);
+		mViewpoints.Emplace(rotation, location);
+	}
+
+	manager->Update(mViewpoints);
+}
+
+TStatId UParkourSignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UParkourSignificanceSubsystem, STATGROUP_Tickables);
+}
+
+EParkourSignificance UParkourSignificanceSubsystem::calcInitialSignificance(AlostandfoundCharacter const* character) const
+{
+	// before the first update there is nobody to be far away from
+	if (mViewpoints.Num() == 0) {
+		return EParkourSignificance::HIGH;
+	}
+
+	// the most significant viewpoint wins, same as the manager
+	EParkourSignificance significance = EParkourSignificance::CULLED;
+	for (FTransform const & viewpoint : mViewpoints) {
+		significance = FMath::Max(significance, calcSignificance(character, viewpoint));
+	}
+	return significance;
+}
+
+EParkourSignificance UParkourSignificanceSubsystem::calcSignificance(AlostandfoundCharacter const* character, FTransform const & viewpoint) const
+{
+	if (character->IsLocallyControlled()) {
+		return EParkourSignificance::HIGH;
+	}
+
+	float const distance = FVector::Dist(character->GetActorLocation(), viewpoint.GetLocation());
+	bool const visible = character->WasRecentlyRendered(0.25f);
+
+	if (distance < mHighDistance) {
+		return EParkourSignificance::HIGH;
+	}
+	if (visible && distance < mMediumDistance) {
+		return EParkourSignificance::MEDIUM;
+	}
+	if (visible || distance < mCullDistance) {
+		return EParkourSignificance::LOW;
+	}
+	return EParkourSignificance::CULLED;
+}
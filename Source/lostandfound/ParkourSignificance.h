@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ParkourSignificance.generated.h"
+
+class AlostandfoundCharacter;
+
+/* Update detail buckets of a character, higher is more significant. */
+UENUM(BlueprintType)
+enum class EParkourSignificance : uint8
+{
+	CULLED		UMETA(DisplayName = "Culled"),
+	LOW			UMETA(DisplayName = "Low"),
+	MEDIUM		UMETA(DisplayName = "Medium"),
+	HIGH		UMETA(DisplayName = "High")
+};
+
+/*
+ * Buckets all registered characters by distance to the closest viewer and visibility through the significance manager.
+ * Characters apply reduced tick rates, low detail special moves and animation URO per bucket, see AlostandfoundCharacter::applySignificance.
+ */
+UCLASS(config=Game)
+class LOSTANDFOUND_API UParkourSignificanceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	void registerCharacter(AlostandfoundCharacter* character);
+	void unregisterCharacter(AlostandfoundCharacter* character);
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/* Characters closer than this to a viewer are always fully updated. */
+	UPROPERTY(config, EditAnywhere, Category = Significance)
+	float mHighDistance = 2500.0f;
+
+	/* Visible characters closer than this are MEDIUM, the rest LOW. */
+	UPROPERTY(config, EditAnywhere, Category = Significance)
+	float mMediumDistance = 8000.0f;
+
+	/* Characters further away than this and not rendered recently are CULLED. */
+	UPROPERTY(config, EditAnywhere, Category = Significance)
+	float mCullDistance = 20000.0f;
+
+private:
+	static const FName Tag;
+
+	EParkourSignificance calcSignificance(AlostandfoundCharacter const* character, FTransform const & viewpoint) const;
+	EParkourSignificance calcInitialSignificance(AlostandfoundCharacter const* character) const;
+
+	TArray<FTransform> mViewpoints;
+};
@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ParkourStreamingSource.h"
+#include "SpecialMovementComponent.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "WorldPartition/WorldPartition.h"
+#include "WorldPartition/WorldPartitionSubsystem.h"
+
+bool FParkourStreamingSourceBand::GetStreamingSource(FWorldPartitionStreamingSource& StreamingSource)
+{
+	return component && component->fillStreamingSource(StreamingSource, name, priority, minTime, maxTime);
+}
+
+UParkourStreamingSourceComponent::UParkourStreamingSourceComponent()
+{
+	// predicted on demand when World Partition asks for the sources
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UParkourStreamingSourceComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	owner = Cast<ACharacter>(GetOwner());
+	specialMoves = owner ? owner->FindComponentByClass<USpecialMovementComponent>() : nullptr;
+
+	UWorldPartitionSubsystem* worldPartition = GetWorld()->GetSubsystem<UWorldPartitionSubsystem>();
+	if (owner == nullptr || specialMoves == nullptr || worldPartition == nullptr || GetWorld()->GetWorldPartition() == nullptr) {
+		return;
+	}
+
+	FString const ownerName = owner->GetName();
+	mUrgentBand.component = this;
+	mUrgentBand.name = FName(*(ownerName + TEXT("_ParkourUrgent")));
+	mUrgentBand.priority = EStreamingSourcePriority::High;
+	mUrgentBand.minTime = 0.0f;
+	mUrgentBand.maxTime = mUrgentTime;
+
+	mAheadBand.component = this;
+	mAheadBand.name = FName(*(ownerName + TEXT("_ParkourAhead")));
+	mAheadBand.priority = EStreamingSourcePriority::Low;
+	mAheadBand.minTime = mUrgentTime;
+	mAheadBand.maxTime = mLookAheadTime;
+
+	worldPartition->RegisterStreamingSourceProvider(&mUrgentBand);
+	worldPartition->RegisterStreamingSourceProvider(&mAheadBand);
+	mRegistered = true;
+}
+
+void UParkourStreamingSourceComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (mRegistered) {
+		if (UWorldPartitionSubsystem* worldPartition = GetWorld()->GetSubsystem<UWorldPartitionSubsystem>()) {
+			worldPartition->UnregisterStreamingSourceProvider(&mUrgentBand);
+			worldPartition->UnregisterStreamingSourceProvider(&mAheadBand);
+		}
+		mRegistered = false;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+bool UParkourStreamingSourceComponent::fillStreamingSource(FWorldPartitionStreamingSource& source, FName name, EStreamingSourcePriority priority, float minTime, float maxTime)
+{
+	// only the own player on a client, every player on the server. AI runners, pooled characters and
+	// the simulated proxies of other players (which are player controlled as well) do not pull in cells
+	bool const streams = owner->IsLocallyControlled() || (owner->HasAuthority() && owner->IsPlayerControlled());
+	if (streams == false) {
+		return false;
+	}
+
+	predictTrajectory();
+
+	FVector const origin = owner->GetActorLocation();
+	source.Name = name;
+	source.Location = origin;
+	// shape locations are relative to the source, keep them in world axes
+	source.Rotation = FRotator::ZeroRotator;
+	source.TargetState = EStreamingSourceTargetState::Activated;
+	source.bBlockOnSlowLoading = false;
+	source.Priority = priority;
+	source.Velocity = mPredictionSpeed;
+	source.Shapes.Reset();
+
+	for (int32 i = 0; i < mNumPredictions; i++) {
+		FPrediction const & prediction = mPredictions[i];
+		if (prediction.time <= minTime || prediction.time > maxTime) {
+			continue;
+		}
+
+		FStreamingSourceShape& shape = source.Shapes.AddDefaulted_GetRef();
+		shape.bUseGridLoadingRange = false;
+		shape.Radius = mBaseRadius + mPredictionSpeed * prediction.time * mRadiusSpread;
+		shape.Location = prediction.location - origin;
+	}
+
+	return source.Shapes.Num() > 0;
+}
+
+void UParkourStreamingSourceComponent::predictTrajectory()
+{
+	if (mPredictionFrame == GFrameCounter) {
+		return;
+	}
+	mPredictionFrame = GFrameCounter;
+	mNumPredictions = 0;
+
+	FSpecialMovementAnimSnapshot const & snapshot = specialMoves->getAnimSnapshot();
+	mPredictionSpeed = snapshot.velocity.Size();
+	if (mPredictionSpeed < mMinSpeed) {
+		return;
+	}
+
+	UCharacterMovementComponent const * move = owner->GetCharacterMovement();
+	float const defaultGravityZ = GetWorld()->GetGravityZ() * owner->GetClass()->GetDefaultObject<ACharacter>()->GetCharacterMovement()->GravityScale;
+
+	FVector position = owner->GetActorLocation();
+	FVector velocity = snapshot.velocity;
+	float const floorZ = position.Z - mMaxDrop;
+
+	// wallruns end with the walljump, afterwards the default gravity applies again
+	bool wallrunning = snapshot.state == ESpecialMovementState::WALLRUN_LEFT || snapshot.state == ESpecialMovementState::WALLRUN_RIGHT;
+	FVector const walljump = wallrunning ? specialMoves->predictLaunchVelocity(specialMoves->makeLaunchQuery(false)) : FVector::ZeroVector;
+	bool falling = snapshot.isFalling || wallrunning;
+	float gravityZ = move->GetGravityZ();
+
+	int32 const subSteps = 4;
+	float const dt = mSampleInterval / subSteps;
+	float time = 0.0f;
+	while (time < mLookAheadTime && mNumPredictions < MaxPredictions) {
+		for (int32 i = 0; i < subSteps; i++) {
+			if (wallrunning && time >= mWallrunTime) {
+				wallrunning = false;
+				velocity += walljump;
+				gravityZ = defaultGravityZ;
+			}
+
+			if (falling) {
+				velocity.Z += gravityZ * dt;
+			}
+			position += velocity * dt;
+			time += dt;
+
+			// landed somewhere below, keep running on the ground
+			if (falling && wallrunning == false && position.Z < floorZ) {
+				position.Z = floorZ;
+				velocity.Z = 0.0f;
+				falling = false;
+			}
+		}
+
+		mPredictions[mNumPredictions++] = { position, time };
+	}
+}
@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "WorldPartition/WorldPartitionStreamingSource.h"
+#include "ParkourStreamingSource.generated.h"
+
+class UParkourStreamingSourceComponent;
+
+/* One priority band of the predicted trajectory, World Partition asks every registered provider once per streaming update. */
+class FParkourStreamingSourceBand : public IWorldPartitionStreamingSourceProvider
+{
+public:
+	virtual bool GetStreamingSource(FWorldPartitionStreamingSource& StreamingSource) override;
+
+	UParkourStreamingSourceComponent* component = nullptr;
+	FName name;
+	EStreamingSourcePriority priority = EStreamingSourcePriority::Default;
+	// arrival time window in seconds
+	float minTime = 0.0f;
+	float maxTime = 0.0f;
+};
+
+/*
+ * World Partition streaming source ahead of a player controlled character.
+ * The trajectory is extrapolated from the velocity and the special movement state (wallrun, walljump, falling) and covered with spheres.
+ * Spheres reached within mUrgentTime request their cells with high priority, the rest of the look ahead with low priority.
+ * The loading range of the grids and the source of the player controller stay untouched.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class LOSTANDFOUND_API UParkourStreamingSourceComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UParkourStreamingSourceComponent();
+
+	/* Seconds of trajectory that are streamed in ahead. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Streaming, meta = (ClampMin = "0.5", UIMin = "0.5"))
+	float mLookAheadTime = 3.0f;
+
+	/* Cells reached within this time are loaded before everything else. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Streaming, meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float mUrgentTime = 1.0f;
+
+	/* Time between two spheres along the trajectory. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Streaming, meta = (ClampMin = "0.1", UIMin = "0.1"))
+	float mSampleInterval = 0.5f;
+
+	/* Sphere radius at the character, it grows with the distance travelled to cover the uncertainty of the prediction. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Streaming, meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float mBaseRadius = 2000.0f;
+
+	/* Radius growth per travelled distance. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Streaming, meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float mRadiusSpread = 0.25f;
+
+	/* Below this speed the streaming source of the player controller is enough. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Streaming, meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float mMinSpeed = 600.0f;
+
+	/* Assumed remaining wallrun time before the character jumps off the wall. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Streaming, meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float mWallrunTime = 0.75f;
+
+	/* Falls are cut off this far below the character, the prediction then continues on the ground. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Streaming, meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float mMaxDrop = 1500.0f;
+
+	/* Fill source with the spheres that are reached between minTime and maxTime. */
+	bool fillStreamingSource(FWorldPartitionStreamingSource& source, FName name, EStreamingSourcePriority priority, float minTime, float maxTime);
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	class ACharacter* owner;
+	class USpecialMovementComponent* specialMoves;
+
+	FParkourStreamingSourceBand mUrgentBand;
+	FParkourStreamingSourceBand mAheadBand;
+	bool mRegistered = false;
+
+	struct FPrediction
+	{
+		FVector location;
+		float time;
+	};
+	static constexpr int32 MaxPredictions = 16;
+	FPrediction mPredictions[MaxPredictions];
+	int32 mNumPredictions = 0;
+	float mPredictionSpeed = 0.0f;
+	uint64 mPredictionFrame = MAX_uint64;
+
+	// every band asks for the same trajectory, predict once per frame
+	void predictTrajectory();
+};
@@ -0,0 +1,477 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ParkourSweepCommandlet.h"
+#include "lostandfoundCharacter.h"
+#include "lostandfoundGameMode.h"
+#include "ParkourSignificance.h"
+#include "AIController.h"
+#include "Components/CapsuleComponent.h"
+#include "EngineUtils.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerStart.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "WorldPartition/WorldPartition.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogParkourSweep, Log, All);
+
+namespace
+{
+	struct FSweepable
+	{
+		TCHAR const * name;
+		float USpecialMovementComponent::* setting;
+	};
+
+	static const FSweepable Sweepables[] =
+	{
+		{ TEXT("innerAngle"), &USpecialMovementComponent::mMaxWallrunInnerAngle },
+		{ TEXT("jumpBoost"), &USpecialMovementComponent::mJumpBoostMultiplier },
+		{ TEXT("wallrunGravity"), &USpecialMovementComponent::mWallrunGravity },
+		{ TEXT("slideDeceleration"), &USpecialMovementComponent::mSlideDeceleration },
+		{ TEXT("slideForce"), &USpecialMovementComponent::mSlideForceMultiplier }
+	};
+
+	void parseFloats(FString const & text, TArray<float>& outValues)
+	{
+		TArray<FString> values;
+		text.ParseIntoArray(values, TEXT(","));
+		for (FString const & value : values) {
+			outValues.Add(FCString::Atof(*value));
+		}
+	}
+
+	// comma list or min:max:step
+	bool parseSweepValues(FString const & text, TArray<float>& outValues)
+	{
+		TArray<FString> range;
+		if (text.ParseIntoArray(range, TEXT(":")) == 3) {
+			float const min = FCString::Atof(*range[0]);
+			float const max = FCString::Atof(*range[1]);
+			float const step = FCString::Atof(*range[2]);
+			if (step <= 0.0f || max < min) {
+				return false;
+			}
+			for (int32 i = 0; min + i * step <= max + KINDA_SMALL_NUMBER; i++) {
+				outValues.Add(min + i * step);
+			}
+		}
+		else {
+			parseFloats(text, outValues);
+		}
+		return outValues.Num() > 0;
+	}
+}
+
+UParkourSweepCommandlet::UParkourSweepCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UParkourSweepCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	FString mapName;
+	if (FParse::Value(*Params, TEXT("map="), mapName) == false) {
+		UE_LOG(LogParkourSweep, Error, TEXT("missing -map=<package name>"));
+		return 1;
+	}
+
+	if (parseParameters(Params) == false) {
+		return 1;
+	}
+
+	FString outPath = FPaths::ProfilingDir() / TEXT("ParkourSweep") / FString::Printf(TEXT("%s_%s.csv"), *FPackageName::GetShortName(mapName), *FDateTime::Now().ToString());
+	FParse::Value(*Params, TEXT("out="), outPath);
+
+	int32 workers = 0;
+	FParse::Value(*Params, TEXT("workers="), workers);
+	if (workers > 1) {
+		return runWorkers(Params, workers, outPath);
+	}
+
+	// child processes of -workers only write their rows, the parent adds the header
+	int32 slice = 0;
+	int32 slices = 1;
+	bool const isWorker = FParse::Value(*Params, TEXT("slice="), slice) && FParse::Value(*Params, TEXT("slices="), slices);
+
+	UWorld* world = loadCourse(mapName);
+	if (world == nullptr) {
+		return 1;
+	}
+
+	FString table = isWorker ? FString() : makeHeader();
+	bool const success = runSlice(world, slice, FMath::Max(slices, 1), table);
+	world->RemoveFromRoot();
+	if (success == false) {
+		return 1;
+	}
+
+	if (FFileHelper::SaveStringToFile(table, *outPath) == false) {
+		UE_LOG(LogParkourSweep, Error, TEXT("failed to write %s"), *outPath);
+		return 1;
+	}
+
+	UE_LOG(LogParkourSweep, Display, TEXT("sweep written to %s"), *outPath);
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+bool UParkourSweepCommandlet::parseParameters(FString const & params)
+{
+	for (FSweepable const & sweepable : Sweepables) {
+		FString text;
+		if (FParse::Value(*params, *FString::Printf(TEXT("%s="), sweepable.name), text, false) == false) {
+			continue;
+		}
+
+		FSweepParameter& parameter = mParameters.AddDefaulted_GetRef();
+		parameter.name = sweepable.name;
+		parameter.setting = sweepable.setting;
+		if (parseSweepValues(text, parameter.values) == false) {
+			UE_LOG(LogParkourSweep, Error, TEXT("invalid values for -%s=%s"), sweepable.name, *text);
+			return false;
+		}
+	}
+
+	FString track;
+	if (FParse::Value(*params, TEXT("track="), track) && mScript.loadFromFile(track) == false) {
+		UE_LOG(LogParkourSweep, Error, TEXT("could not load input track %s"), *track);
+		return false;
+	}
+
+	FString finish;
+	if (FParse::Value(*params, TEXT("finish="), finish, false)) {
+		TArray<float> values;
+		parseFloats(finish, values);
+		if (values.Num() != 3) {
+			UE_LOG(LogParkourSweep, Error, TEXT("-finish= needs X,Y,Z"));
+			return false;
+		}
+		mFinish = FVector(values[0], values[1], values[2]);
+		mHasFinish = true;
+	}
+
+	FString start;
+	if (FParse::Value(*params, TEXT("start="), start, false)) {
+		TArray<float> values;
+		parseFloats(start, values);
+		if (values.Num() != 4) {
+			UE_LOG(LogParkourSweep, Error, TEXT("-start= needs X,Y,Z,Yaw"));
+			return false;
+		}
+		mStart = FTransform(FRotator(0.0f, values[3], 0.0f), FVector(values[0], values[1], values[2]));
+		mHasStart = true;
+	}
+
+	FParse::Value(*params, TEXT("finishRadius="), mFinishRadius);
+	FParse::Value(*params, TEXT("time="), mSimTime);
+	FParse::Value(*params, TEXT("step="), mStep);
+	FParse::Value(*params, TEXT("batch="), mBatchSize);
+	mStep = FMath::Clamp(mStep, 0.002f, 0.1f);
+	mBatchSize = FMath::Max(mBatchSize, 1);
+
+	FString characterPath;
+	if (FParse::Value(*params, TEXT("character="), characterPath)) {
+		mCharacterClass = LoadClass<AlostandfoundCharacter>(nullptr, *characterPath);
+	}
+	else {
+		mCharacterClass = GetDefault<AlostandfoundGameMode>()->mPlayerPawnClass.LoadSynchronous();
+	}
+	if (mCharacterClass == nullptr) {
+		UE_LOG(LogParkourSweep, Error, TEXT("could not load the character class"));
+		return false;
+	}
+
+	return true;
+}
+
+int32 UParkourSweepCommandlet::getNumCombinations() const
+{
+	int32 combinations = 1;
+	for (FSweepParameter const & parameter : mParameters) {
+		combinations *= parameter.values.Num();
+	}
+	return combinations;
+}
+
+float UParkourSweepCommandlet::getValue(int32 combination, int32 parameter) const
+{
+	// mixed radix, the first parameter changes fastest
+	for (int32 i = 0; i < parameter; i++) {
+		combination /= mParameters[i].values.Num();
+	}
+	TArray<float> const & values = mParameters[parameter].values;
+	return values[combination % values.Num()];
+}
+
+FString UParkourSweepCommandlet::makeHeader() const
+{
+	FString header;
+	for (FSweepParameter const & parameter : mParameters) {
+		header += parameter.name + TEXT(",");
+	}
+	header += TEXT("completion_s,distance,wallruns,wallrun_success,cpu_us_per_step\n");
+	return header;
+}
+
+int32 UParkourSweepCommandlet::runWorkers(FString const & params, int32 workers, FString const & outPath)
+{
+	TArray<FString> tokens;
+	TArray<FString> switches;
+	UCommandlet::ParseCommandLine(*params, tokens, switches);
+
+	// same sweep for every child, without the worker and output switches
+	FString childParams;
+	for (FString const & option : switches) {
+		if (option.StartsWith(TEXT("workers=")) == false && option.StartsWith(TEXT("out=")) == false && option.StartsWith(TEXT("run=")) == false) {
+			childParams += FString::Printf(TEXT(" -%s"), *option);
+		}
+	}
+
+	workers = FMath::Min(workers, getNumCombinations());
+	TArray<FProcHandle> processes;
+	TArray<FString> partPaths;
+	for (int32 i = 0; i < workers; i++) {
+		FString const partPath = FString::Printf(TEXT("%s.part%d"), *outPath, i);
+		FString const args = FString::Printf(TEXT("\"%s\" -run=ParkourSweep%s -slice=%d -slices=%d -out=\"%s\" -nullrhi -unattended -nopause"),
+			*FPaths::GetProjectFilePath(), *childParams, i, workers, *partPath);
+
+		FProcHandle process = FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *args, true, true, true, nullptr, 0, nullptr, nullptr);
+		if (process.IsValid() == false) {
+			UE_LOG(LogParkourSweep, Error, TEXT("failed to start worker %d"), i);
+			continue;
+		}
+		processes.Add(process);
+		partPaths.Add(partPath);
+	}
+
+	UE_LOG(LogParkourSweep, Display, TEXT("%d combinations on %d workers"), getNumCombinations(), processes.Num());
+
+	FString table = makeHeader();
+	int32 result = processes.Num() == workers ? 0 : 1;
+	for (int32 i = 0; i < processes.Num(); i++) {
+		FPlatformProcess::WaitForProc(processes[i]);
+
+		int32 returnCode = 0;
+		FPlatformProcess::GetProcReturnCode(processes[i], &returnCode);
+		FPlatformProcess::CloseProc(processes[i]);
+
+		FString part;
+		if (returnCode != 0 || FFileHelper::LoadFileToString(part, *partPaths[i]) == false) {
+			UE_LOG(LogParkourSweep, Error, TEXT("worker %d failed with %d"), i, returnCode);
+			result = 1;
+			continue;
+		}
+		table += part;
+		IFileManager::Get().Delete(*partPaths[i]);
+	}
+
+	if (FFileHelper::SaveStringToFile(table, *outPath) == false) {
+		UE_LOG(LogParkourSweep, Error, TEXT("failed to write %s"), *outPath);
+		return 1;
+	}
+
+	UE_LOG(LogParkourSweep, Display, TEXT("sweep written to %s"), *outPath);
+	return result;
+}
+
+UWorld* UParkourSweepCommandlet::loadCourse(FString const & mapName)
+{
+	UPackage* package = LoadPackage(nullptr, *mapName, LOAD_None);
+	UWorld* world = package ? UWorld::FindWorldInPackage(package) : nullptr;
+	if (world == nullptr) {
+		UE_LOG(LogParkourSweep, Error, TEXT("could not load map %s"), *mapName);
+		return nullptr;
+	}
+
+	world->WorldType = EWorldType::Editor;
+	world->AddToRoot();
+	if (world->bIsWorldInitialized == false) {
+		UWorld::InitializationValues initValues;
+		initValues.RequiresHitProxies(false).ShouldSimulatePhysics(false).EnableTraceCollision(true).CreateNavigation(false).AllowAudioPlayback(false).CreateFXSystem(false);
+		world->InitWorld(initValues);
+	}
+	world->UpdateWorldComponents(true, false);
+
+	// the whole course has to be resident, there is no streaming source
+	if (UWorldPartition* worldPartition = world->GetWorldPartition()) {
+		worldPartition->LoadEditorCells(FBox(FVector(-HALF_WORLD_MAX), FVector(HALF_WORLD_MAX)), false);
+	}
+
+	// from here on it runs like a game: timers, BeginPlay and spawned controllers
+	world->WorldType = EWorldType::Game;
+	FWorldContext& context = GEngine->CreateNewWorldContext(EWorldType::Game);
+	context.SetCurrentWorld(world);
+	world->InitializeActorsForPlay(FURL());
+	world->GetWorldSettings()->NotifyBeginPlay();
+
+	if (mHasStart == false) {
+		TActorIterator<APlayerStart> it(world);
+		if (it) {
+			mStart = it->GetActorTransform();
+		}
+		else {
+			UE_LOG(LogParkourSweep, Warning, TEXT("map %s has no player start and no -start=X,Y,Z,Yaw was given, starting at the origin"), *mapName);
+		}
+	}
+
+	return world;
+}
+
+bool UParkourSweepCommandlet::runSlice(UWorld* world, int32 slice, int32 slices, FString& outTable)
+{
+	TArray<FSimulation> batch;
+	batch.Reserve(mBatchSize);
+
+	int32 const combinations = getNumCombinations();
+	for (int32 combination = slice; combination < combinations; combination += slices) {
+		FSimulation& sim = batch.AddDefaulted_GetRef();
+		sim.combination = combination;
+		sim.script = mScript;
+
+		if (batch.Num() == mBatchSize) {
+			runBatch(world, batch, outTable);
+			batch.Reset();
+		}
+	}
+	if (batch.Num() > 0) {
+		runBatch(world, batch, outTable);
+	}
+
+	return true;
+}
+
+AlostandfoundCharacter* UParkourSweepCommandlet::spawnSimulation(UWorld* world, int32 combination)
+{
+	FActorSpawnParameters spawnParams;
+	spawnParams.ObjectFlags |= RF_Transient;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	AlostandfoundCharacter* character = world->SpawnActor<AlostandfoundCharacter>(mCharacterClass, mStart, spawnParams);
+	if (character == nullptr) {
+		return nullptr;
+	}
+
+	character->SpawnDefaultController();
+	if (AAIController* ai = Cast<AAIController>(character->GetController())) {
+		// the script turns through the control rotation, do not let the pawn overwrite it
+		ai->bSetControlRotationFromPawnOrientation = false;
+		ai->SetControlRotation(mStart.Rotator());
+	}
+
+	// all simulations of a batch start at the same spot and must not push each other
+	character->GetCapsuleComponent()->SetCollisionResponseToChannel(ECollisionChannel::ECC_Pawn, ECollisionResponse::ECR_Ignore);
+
+	// stepped by the sweep to measure every simulation on its own, the mesh is not needed at all
+	character->SetActorTickEnabled(false);
+	character->GetCharacterMovement()->SetComponentTickEnabled(false);
+	character->GetSpecialMoves()->SetComponentTickEnabled(false);
+	character->GetMesh()->SetComponentTickEnabled(false);
+
+	if (UParkourSignificanceSubsystem* significance = world->GetSubsystem<UParkourSignificanceSubsystem>()) {
+		significance->unregisterCharacter(character);
+	}
+
+	USpecialMovementComponent* moves = character->GetSpecialMoves();
+	moves->setLowDetail(false);
+	for (int32 i = 0; i < mParameters.Num(); i++) {
+		moves->*mParameters[i].setting = getValue(combination, i);
+	}
+
+	return character;
+}
+
+void UParkourSweepCommandlet::stepSimulation(FSimulation& sim)
+{
+	AlostandfoundCharacter* character = sim.character.Get();
+	if (character == nullptr) {
+		return;
+	}
+
+	UCharacterMovementComponent* move = character->GetCharacterMovement();
+	USpecialMovementComponent* moves = character->GetSpecialMoves();
+
+	// same order as in game: input, special moves (buffered jumps), movement
+	uint64 const startCycles = FPlatformTime::Cycles64();
+	sim.script.tick(mStep, character);
+	moves->TickComponent(mStep, LEVELTICK_All, &moves->PrimaryComponentTick);
+	move->TickComponent(mStep, LEVELTICK_All, &move->PrimaryComponentTick);
+	sim.cycles += FPlatformTime::Cycles64() - startCycles;
+	sim.steps++;
+
+	// a wallrun succeeds when the character jumps off the wall instead of dropping off
+	bool const wallrunning = moves->mState == ESpecialMovementState::WALLRUN_LEFT || moves->mState == ESpecialMovementState::WALLRUN_RIGHT;
+	if (wallrunning && sim.wasWallrunning == false) {
+		sim.wallruns++;
+	}
+	else if (wallrunning == false && sim.wasWallrunning && move->Velocity.Z >= move->JumpZVelocity * 0.5f) {
+		sim.walljumps++;
+	}
+	sim.wasWallrunning = wallrunning;
+}
+
+void UParkourSweepCommandlet::runBatch(UWorld* world, TArray<FSimulation>& batch, FString& outTable)
+{
+	for (FSimulation& sim : batch) {
+		sim.character = spawnSimulation(world, sim.combination);
+		sim.start = mStart.GetLocation();
+	}
+
+	float const finishRadiusSq = mFinishRadius * mFinishRadius;
+	float time = 0.0f;
+	while (time < mSimTime) {
+		bool running = false;
+		for (FSimulation& sim : batch) {
+			if (sim.completionTime < 0.0f) {
+				stepSimulation(sim);
+				running = true;
+			}
+		}
+		if (running == false) {
+			break;
+		}
+
+		// timers and everything else in the course
+		world->Tick(LEVELTICK_All, mStep);
+		time += mStep;
+
+		if (mHasFinish) {
+			for (FSimulation& sim : batch) {
+				AlostandfoundCharacter* character = sim.character.Get();
+				if (sim.completionTime < 0.0f && character && FVector::DistSquared(character->GetActorLocation(), mFinish) <= finishRadiusSq) {
+					sim.completionTime = time;
+				}
+			}
+		}
+	}
+
+	for (FSimulation& sim : batch) {
+		AlostandfoundCharacter* character = sim.character.Get();
+		float const distance = character ? FVector::Dist(character->GetActorLocation(), sim.start) : 0.0f;
+		double const cpuPerStep = sim.steps > 0 ? FPlatformTime::ToMilliseconds64(sim.cycles) * 1000.0 / sim.steps : 0.0;
+		float const wallrunSuccess = sim.wallruns > 0 ? (float)sim.walljumps / sim.wallruns : 0.0f;
+
+		for (int32 i = 0; i < mParameters.Num(); i++) {
+			outTable += FString::Printf(TEXT("%g,"), getValue(sim.combination, i));
+		}
+		outTable += FString::Printf(TEXT("%.3f,%.0f,%d,%.3f,%.2f\n"), sim.completionTime, distance, sim.wallruns, wallrunSuccess, cpuPerStep);
+
+		if (character) {
+			if (AController* controller = character->GetController()) {
+				controller->Destroy();
+			}
+			character->Destroy();
+		}
+	}
+
+	UE_LOG(LogParkourSweep, Display, TEXT("simulated %d combinations"), batch.Num());
+}
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ParkourInputScript.h"
+#include "SpecialMovementComponent.h"
+#include "ParkourSweepCommandlet.generated.h"
+
+class AlostandfoundCharacter;
+
+/*
+ * Headless movement tuning: runs the scripted input track on a course for every combination of the swept parameters
+ * and writes completion time, wallrun success rate and simulation cost per combination to Saved/Profiling/ParkourSweep/<map>_<date>.csv.
+ *
+ * Usage: UnrealEditor-Cmd lostandfound.uproject -run=ParkourSweep -map=/Game/ThirdPerson/Maps/ThirdPersonMap -workers=8
+ *		-innerAngle=60,70,80 -jumpBoost=1.5:2.0:0.25 -wallrunGravity=0.2,0.25 -slideDeceleration=300,400 -slideForce=0.75
+ *		[-track=file] [-start=X,Y,Z,Yaw] [-finish=X,Y,Z] [-finishRadius=200] [-time=30] [-step=0.0166] [-batch=64] [-character=/Game/...BP_C]
+ *
+ * A parameter is a comma list or min:max:step, parameters that are not given keep the character defaults.
+ * Characters move through the shared world, they can not run in parallel inside one process.
+ * -workers=N splits the grid over N child processes instead and merges their tables.
+ * The simulations of a process run side by side in batches, they ignore each other and are ticked one after another with a fixed step.
+ */
+UCLASS()
+class UParkourSweepCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UParkourSweepCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	struct FSweepParameter
+	{
+		FString name;
+		float USpecialMovementComponent::* setting;
+		TArray<float> values;
+	};
+
+	struct FSimulation
+	{
+		int32 combination;
+		TWeakObjectPtr<AlostandfoundCharacter> character;
+		FParkourInputScript script;
+		FVector start;
+		float completionTime = -1.0f;
+		int32 wallruns = 0;
+		int32 walljumps = 0;
+		bool wasWallrunning = false;
+		uint64 cycles = 0;
+		int32 steps = 0;
+	};
+
+	TArray<FSweepParameter> mParameters;
+	FParkourInputScript mScript = FParkourInputScript::makeDefault();
+	TSubclassOf<AlostandfoundCharacter> mCharacterClass;
+	FTransform mStart = FTransform::Identity;
+	bool mHasStart = false;
+	FVector mFinish = FVector::ZeroVector;
+	bool mHasFinish = false;
+	float mFinishRadius = 200.0f;
+	float mSimTime = 30.0f;
+	float mStep = 1.0f / 60.0f;
+	int32 mBatchSize = 64;
+
+	bool parseParameters(FString const & params);
+	int32 getNumCombinations() const;
+	float getValue(int32 combination, int32 parameter) const;
+	FString makeHeader() const;
+
+	int32 runWorkers(FString const & params, int32 workers, FString const & outPath);
+	bool runSlice(UWorld* world, int32 slice, int32 slices, FString& outTable);
+	void runBatch(UWorld* world, TArray<FSimulation>& batch, FString& outTable);
+	AlostandfoundCharacter* spawnSimulation(UWorld* world, int32 combination);
+	void stepSimulation(FSimulation& sim);
+	UWorld* loadCourse(FString const & mapName);
+};
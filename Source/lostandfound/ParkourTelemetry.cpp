@@ -0,0 +1,214 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ParkourTelemetry.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogParkourTelemetry, Log, All);
+
+static TAutoConsoleVariable<bool> CVarParkourTelemetry(
+	TEXT("lf.Telemetry"),
+	false,
+	TEXT("Record parkour telemetry events to Saved/Telemetry."));
+
+namespace ParkourTelemetry
+{
+	std::atomic<bool> GEnabled { false };
+
+	struct FTelemetryEvent
+	{
+		double time;
+		uint32 actorId;
+		float value;
+		uint8 type;
+		uint8 detail;
+	};
+
+	// single producer (the owning thread), single consumer (the writer thread)
+	struct FThreadBuffer
+	{
+		static constexpr uint32 Capacity = 4096;
+
+		FTelemetryEvent events[Capacity];
+		std::atomic<uint32> writeCount { 0 };
+		std::atomic<uint32> readCount { 0 };
+		std::atomic<uint32> dropped { 0 };
+	};
+
+	// buffers are registered once per thread and never freed, recording threads live as long as the process
+	static FCriticalSection GBuffersLock;
+	static TArray<FThreadBuffer*> GBuffers;
+
+	static FThreadBuffer* getThreadBuffer()
+	{
+		static thread_local FThreadBuffer* buffer = nullptr;
+		if (buffer == nullptr) {
+			buffer = new FThreadBuffer();
+			FScopeLock lock(&GBuffersLock);
+			GBuffers.Add(buffer);
+		}
+		return buffer;
+	}
+
+	void recordEvent(EParkourTelemetryEvent type, uint32 actorId, uint8 detail, float value)
+	{
+		FThreadBuffer* buffer = getThreadBuffer();
+		uint32 const write = buffer->writeCount.load(std::memory_order_relaxed);
+		if (write - buffer->readCount.load(std::memory_order_acquire) >= FThreadBuffer::Capacity) {
+			buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		FTelemetryEvent& event = buffer->events[write % FThreadBuffer::Capacity];
+		event.time = FPlatformTime::Seconds() - GStartTime;
+		event.actorId = actorId;
+		event.value = value;
+		event.type = (uint8)type;
+		event.detail = detail;
+		buffer->writeCount.store(write + 1, std::memory_order_release);
+	}
+
+	static const TCHAR* const EventNames[] =
+	{
+		TEXT("wallrun_start"),
+		TEXT("wallrun_end"),
+		TEXT("slide_end"),
+		TEXT("jump_boost"),
+		TEXT("walljump"),
+		TEXT("walljump_chain"),
+		TEXT("state_time")
+	};
+}
+
+class FParkourTelemetryWriter : public FRunnable
+{
+public:
+	FParkourTelemetryWriter()
+	{
+		FString const path = FPaths::ProjectSavedDir() / TEXT("Telemetry") / FDateTime::Now().ToString() + TEXT(".csv");
+		mFile.Reset(IFileManager::Get().CreateFileWriter(*path));
+		writeText(TEXT("time,actor,event,detail,value\n"));
+
+		mWakeUp = FPlatformProcess::GetSynchEventFromPool();
+	}
+
+	virtual ~FParkourTelemetryWriter()
+	{
+		FPlatformProcess::ReturnSynchEventToPool(mWakeUp);
+	}
+
+	virtual uint32 Run() override
+	{
+		while (mStop.load() == false) {
+			mWakeUp->Wait(FTimespan::FromMilliseconds(100.0));
+			drain();
+		}
+		drain();
+
+		if (mFile.IsValid()) {
+			mFile->Close();
+		}
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		mStop.store(true);
+		mWakeUp->Trigger();
+	}
+
+private:
+	TUniquePtr<FArchive> mFile;
+	FEvent* mWakeUp;
+	std::atomic<bool> mStop { false };
+	FString mLine;
+
+	void writeText(FString const & text)
+	{
+		if (mFile.IsValid()) {
+			auto const utf8 = StringCast<UTF8CHAR>(*text);
+			mFile->Serialize((void*)utf8.Get(), utf8.Length());
+		}
+	}
+
+	void drain()
+	{
+		using namespace ParkourTelemetry;
+
+		TArray<FThreadBuffer*> buffers;
+		{
+			FScopeLock lock(&GBuffersLock);
+			buffers = GBuffers;
+		}
+
+		for (FThreadBuffer* buffer : buffers) {
+			uint32 const read = buffer->readCount.load(std::memory_order_relaxed);
+			uint32 const write = buffer->writeCount.load(std::memory_order_acquire);
+
+			for (uint32 i = read; i != write; i++) {
+				FTelemetryEvent const & event = buffer->events[i % FThreadBuffer::Capacity];
+				mLine.Reset();
+				mLine.Appendf(TEXT("%.4f,%u,%s,%u,%.4f\n"), event.time, event.actorId, EventNames[event.type], event.detail, event.value);
+				writeText(mLine);
+			}
+			buffer->readCount.store(write, std::memory_order_release);
+
+			if (uint32 const dropped = buffer->dropped.exchange(0, std::memory_order_relaxed)) {
+				UE_LOG(LogParkourTelemetry, Warning, TEXT("dropped %u events, buffer full"), dropped);
+			}
+		}
+
+		if (mFile.IsValid()) {
+			mFile->Flush();
+		}
+	}
+};
+
+void UParkourTelemetrySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("ParkourTelemetry"))) {
+		CVarParkourTelemetry->Set(true);
+	}
+
+	CVarParkourTelemetry->SetOnChangedCallback(FConsoleVariableDelegate::CreateWeakLambda(this, [this](IConsoleVariable* variable) {
+		setEnabled(variable->GetBool());
+	}));
+	setEnabled(CVarParkourTelemetry.GetValueOnGameThread());
+}
+
+void UParkourTelemetrySubsystem::Deinitialize()
+{
+	// the cvar outlives the game instance, do not leave it calling into a destroyed subsystem
+	CVarParkourTelemetry->SetOnChangedCallback(FConsoleVariableDelegate());
+	setEnabled(false);
+
+	Super::Deinitialize();
+}
+
+void UParkourTelemetrySubsystem::setEnabled(bool enabled)
+{
+	if (enabled == (mWriterThread != nullptr)) {
+		return;
+	}
+
+	if (enabled) {
+		mWriter = new FParkourTelemetryWriter();
+		mWriterThread = FRunnableThread::Create(mWriter, TEXT("ParkourTelemetryWriter"), 0, TPri_BelowNormal);
+		ParkourTelemetry::GEnabled.store(true);
+	}
+	else {
+		ParkourTelemetry::GEnabled.store(false);
+		// Kill stops the writer, which drains the remaining events before the thread ends
+		mWriterThread->Kill(true);
+		delete mWriterThread;
+		mWriterThread = nullptr;
+		delete mWriter;
+		mWriter = nullptr;
+	}
+}
@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include <atomic>
+#include "ParkourTelemetry.generated.h"
+
+enum class EParkourTelemetryEvent : uint8
+{
+	WALLRUN_START,		/* detail: wallrun state */
+	WALLRUN_END,		/* detail: EWallrunEndReason, value: wallrun duration */
+	SLIDE_END,			/* value: slide duration */
+	JUMP_BOOST,			/* value: horizontal speed before the boost */
+	WALLJUMP,			/* value: walljumps in the current chain */
+	WALLJUMP_CHAIN,		/* value: walljumps chained before landing */
+	STATE_TIME			/* detail: ESpecialMovementState, value: seconds spent in the state */
+};
+
+/*
+ * Gameplay telemetry, enabled with -ParkourTelemetry or lf.Telemetry 1.
+ * Recording an event only writes to a lock-free buffer of the calling thread, a writer thread drains all buffers
+ * into Saved/Telemetry/<timestamp>.csv.
+ */
+namespace ParkourTelemetry
+{
+	extern LOSTANDFOUND_API std::atomic<bool> GEnabled;
+
+	LOSTANDFOUND_API void recordEvent(EParkourTelemetryEvent type, uint32 actorId, uint8 detail, float value);
+
+	FORCEINLINE void record(EParkourTelemetryEvent type, uint32 actorId, uint8 detail = 0, float value = 0.0f)
+	{
+		if (GEnabled.load(std::memory_order_relaxed)) {
+			recordEvent(type, actorId, detail, value);
+		}
+	}
+}
+
+UCLASS()
+class LOSTANDFOUND_API UParkourTelemetrySubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/* Start or stop the writer thread. Events recorded while stopped are dropped. */
+	void setEnabled(bool enabled);
+
+private:
+	class FParkourTelemetryWriter* mWriter = nullptr;
+	class FRunnableThread* mWriterThread = nullptr;
+};
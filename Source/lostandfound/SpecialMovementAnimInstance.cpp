@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SpecialMovementAnimInstance.h"
+#include "Components/SkeletalMeshComponent.h"
+
+void USpecialMovementAnimInstance::NativeInitializeAnimation()
+{
+	Super::NativeInitializeAnimation();
+
+	AActor* owner = GetOwningActor();
+	specialMoves = owner ? owner->FindComponentByClass<USpecialMovementComponent>() : nullptr;
+}
+
+void USpecialMovementAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
+{
+	Super::NativeUpdateAnimation(DeltaSeconds);
+
+	// game thread: only copy, the component refreshes the snapshot before the mesh ticks
+	if (specialMoves) {
+		mSnapshot = specialMoves->getAnimSnapshot();
+		if (mPoseDatabase) {
+			specialMoves->predictTrajectory(FParkourPoseFeatures::TrajectoryTimes, FParkourPoseFeatures::NumTrajectoryPoints, mTrajectory);
+		}
+	}
+	if (AActor* owner = GetOwningActor()) {
+		mActorTransform = owner->GetActorTransform();
+	}
+	if (USkeletalMeshComponent* mesh = GetSkelMeshComponent()) {
+		mMeshTransform = mesh->GetComponentTransform();
+	}
+}
+
+void USpecialMovementAnimInstance::NativeThreadSafeUpdateAnimation(float DeltaSeconds)
+{
+	Super::NativeThreadSafeUpdateAnimation(DeltaSeconds);
+
+	mState = mSnapshot.state;
+	mIsFalling = mSnapshot.isFalling;
+	mGroundSpeed = FVector2D(mSnapshot.velocity).Length();
+
+	bool const left = mState == ESpecialMovementState::WALLRUN_LEFT;
+	bool const right = mState == ESpecialMovementState::WALLRUN_RIGHT;
+	bool const ledge = mState == ESpecialMovementState::ON_LEDGE || mState == ESpecialMovementState::LEDGE_PULL;
+	mIsWallrunning = left || right || mState == ESpecialMovementState::WALLRUN_UP;
+
+	if (mIsWallrunning) {
+		mLocalWallNormal = mActorTransform.InverseTransformVectorNoScale(mSnapshot.wallNormal);
+	}
+
+	// keep the side while blending out so the pose does not flip
+	if (left || right) {
+		mWallrunSide = FMath::FInterpTo(mWallrunSide, left ? -1.0f : 1.0f, DeltaSeconds, mBlendSpeed);
+	}
+
+	mWallrunWeight = FMath::FInterpTo(mWallrunWeight, mIsWallrunning ? 1.0f : 0.0f, DeltaSeconds, mBlendSpeed);
+	mSlideWeight = FMath::FInterpTo(mSlideWeight, mState == ESpecialMovementState::SLIDE ? 1.0f : 0.0f, DeltaSeconds, mBlendSpeed);
+	mLedgeWeight = FMath::FInterpTo(mLedgeWeight, ledge ? 1.0f : 0.0f, DeltaSeconds, mBlendSpeed);
+
+	if (mPoseDatabase) {
+		updateMotionMatching(DeltaSeconds);
+	}
+}
+
+void USpecialMovementAnimInstance::updateMotionMatching(float DeltaSeconds)
+{
+	// the sequence evaluator in the graph plays on from the matched time
+	mMatchedTime += DeltaSeconds;
+	mSearchTimer -= DeltaSeconds;
+	if (mSearchTimer > 0.0f && mState == mSearchedState && mMatchedSource != INDEX_NONE) {
+		return;
+	}
+	mSearchTimer = mSearchInterval;
+	mSearchedState = mState;
+
+	// pose features of the current pose, velocity and trajectory from the special movement state
+	int32 const currentPose = mMatchedSource != INDEX_NONE ? mPoseDatabase->findPose(mMatchedSource, mMatchedTime) : INDEX_NONE;
+	FParkourPoseFeatures query;
+	if (currentPose != INDEX_NONE) {
+		mPoseDatabase->getPoseFeatures(currentPose, query);
+	}
+
+	FVector velocity = mSnapshot.velocity;
+	if (mIsWallrunning) {
+		// the wallrun follows the wall, not the momentum
+		velocity = mSnapshot.wallrunDir * FVector2D(mSnapshot.velocity).Length() + FVector(0.0f, 0.0f, mSnapshot.velocity.Z);
+	}
+	FVector const localVelocity = mMeshTransform.InverseTransformVectorNoScale(velocity);
+	query.setVelocity(localVelocity);
+	for (int32 i = 0; i < FParkourPoseFeatures::NumTrajectoryPoints; i++) {
+		query.setTrajectoryPoint(i, FVector2D(mMeshTransform.InverseTransformVectorNoScale(mTrajectory[i])));
+	}
+
+	FParkourPoseMatch match;
+	if (mPoseDatabase->search(query, mState, mMaxSearchLeaves, match) == false) {
+		return;
+	}
+
+	// stay on the current pose unless the match is clearly better, avoids pose jitter
+	bool const currentValid = currentPose != INDEX_NONE && mPoseDatabase->mSources[mMatchedSource].state == mState;
+	if (currentValid && match.cost >= mPoseDatabase->calcCost(query, currentPose) * (1.0f - mContinuingBias)) {
+		return;
+	}
+
+	mMatchedSequence = match.sequence;
+	mMatchedSource = match.source;
+	mMatchedTime = match.time;
+	mMatchCount++;
+}
@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimInstance.h"
+#include "SpecialMovementComponent.h"
+#include "ParkourPoseDatabase.h"
+#include "SpecialMovementAnimInstance.generated.h"
+
+/*
+ * Native anim instance for characters with a USpecialMovementComponent, reparent the character anim blueprint to it.
+ * The game thread only copies the component snapshot, all blend parameters are computed in NativeThreadSafeUpdateAnimation.
+ * Read the parameters in the anim graph by plain member access so the graph stays on the fast path.
+ */
+UCLASS()
+class LOSTANDFOUND_API USpecialMovementAnimInstance : public UAnimInstance
+{
+	GENERATED_BODY()
+
+public:
+	virtual void NativeInitializeAnimation() override;
+	virtual void NativeUpdateAnimation(float DeltaSeconds) override;
+	virtual void NativeThreadSafeUpdateAnimation(float DeltaSeconds) override;
+
+	/* Blend speed of the wallrun, slide and ledge weights. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Settings, meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float mBlendSpeed = 12.0f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = SpecialMovement)
+	ESpecialMovementState mState;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = SpecialMovement)
+	bool mIsWallrunning;
+
+	/* -1.0 wall on the left, 1.0 wall on the right, blended. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = SpecialMovement)
+	float mWallrunSide;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = SpecialMovement)
+	float mWallrunWeight;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = SpecialMovement)
+	float mSlideWeight;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = SpecialMovement)
+	float mLedgeWeight;
+
+	/* Wall normal in actor space, valid while wallrunning. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = SpecialMovement)
+	FVector mLocalWallNormal;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = SpecialMovement)
+	float mGroundSpeed;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = SpecialMovement)
+	bool mIsFalling;
+
+	/* Optional motion matching, play mMatchedSequence at mMatchedTime in the graph and inertialize when mMatchCount changes. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = MotionMatching)
+	UParkourPoseDatabase* mPoseDatabase = nullptr;
+
+	/* Seconds between two searches, a state change searches right away. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = MotionMatching, meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float mSearchInterval = 0.1f;
+
+	/* Index leaves visited per search, bounds the search cost per character. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = MotionMatching, meta = (ClampMin = "1", UIMin = "1"))
+	int32 mMaxSearchLeaves = 16;
+
+	/* A match has to be this much cheaper than continuing the current pose, relative. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = MotionMatching, meta = (ClampMin = "0.0", ClampMax = "1.0", UIMin = "0.0", UIMax = "1.0"))
+	float mContinuingBias = 0.2f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = MotionMatching)
+	UAnimSequence* mMatchedSequence = nullptr;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = MotionMatching)
+	float mMatchedTime = 0.0f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = MotionMatching)
+	int32 mMatchCount = 0;
+
+private:
+	void updateMotionMatching(float DeltaSeconds);
+
+	int32 mMatchedSource = INDEX_NONE;
+	float mSearchTimer = 0.0f;
+	ESpecialMovementState mSearchedState = ESpecialMovementState::NONE;
+	FTransform mMeshTransform;
+
+	UPROPERTY(Transient)
+	class USpecialMovementComponent* specialMoves;
+
+	// copied on the game thread, only read on the worker thread
+	FSpecialMovementAnimSnapshot mSnapshot;
+	FTransform mActorTransform;
+	// world space offsets at FParkourPoseFeatures::TrajectoryTimes, predicted by the special moves
+	FVector mTrajectory[FParkourPoseFeatures::NumTrajectoryPoints];
+};
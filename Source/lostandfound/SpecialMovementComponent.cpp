@@ -9,11 +9,31 @@
 #include "GameFramework/SpringArmComponent.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
+#include "Components/BoxComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "Async/ParallelFor.h"
+#include "ParkourMemory.h"
+#include "ParkourTelemetry.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+CSV_DEFINE_CATEGORY(Parkour, true);
 
-#define IGNORE_SELF_COLLISION_PARAM FCollisionQueryParams(FName(TEXT("KnockTraceSingle")), true, owner)
 #define CAPSULE_RADIUS owner->GetCapsuleComponent()->GetScaledCapsuleRadius()
 #define WALLRUN_REPLACEMENT CAPSULE_RADIUS * 1.2f
 
+const USpecialMovementComponent::FStateHooks USpecialMovementComponent::StateHooks[SpecialMovementTransitions::NumStates] =
+{
+	/* NONE */			{ nullptr, nullptr },
+	/* WALLRUN_LEFT */	{ nullptr, nullptr },
+	/* WALLRUN_RIGHT */	{ nullptr, nullptr },
+	/* WALLRUN_UP */	{ nullptr, nullptr },
+	/* SLIDE */			{ nullptr, &USpecialMovementComponent::exitSlide },
+	/* ON_LEDGE */		{ nullptr, nullptr },
+	/* LEDGE_PULL */	{ nullptr, nullptr }
+};
+
 // Sets default values for this component's properties
 USpecialMovementComponent::USpecialMovementComponent()
 {
@@ -36,6 +56,8 @@ void USpecialMovementComponent::BeginPlay()
 	mMaxWallrunInnerAngle = FMath::Clamp(mMaxWallrunOuterAngle, 45.0f, 180.0f);
 	mMaxWallrunStartAngle = FMath::Clamp(mMaxWallrunStartAngle, 0.0f, 90.0f);
 
+	bakeProfiles();
+
 	// slowmo wallrun for testing
 	// mWallrunSpeed *= 0.1f;
 	// mWallrunGravity = 0.005f;
@@ -61,18 +83,195 @@ void USpecialMovementComponent::Init(ACharacter* parent, UCameraComponent* paren
 	mDefaultGroundFriction = move->GroundFriction;
 	mDefaultBrakingDecelerationWalking = move->BrakingDecelerationWalking;
 	mDefaultMaxWalkSpeedCrouched = move->MaxWalkSpeedCrouched;
+
+	mDefaultCameraCollisionTest = cameraStick ? cameraStick->bDoCollisionTest : true;
+
+	// built once, the hot path traces must not construct params (and their ignore lists) every time
+	mQueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(SpecialMovement), true, owner);
 }
 
 // Called every frame
 void USpecialMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
+	CSV_SCOPED_TIMING_STAT(Parkour, SpecialMovementTick);
+	LLM_SCOPE_BYTAG(Parkour);
+	PARKOUR_ALLOCATION_CHECK_SCOPE(SpecialMovementTick);
+
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
+	if (move->IsFalling() == false) {
+		mLastGroundTime = GetWorld()->GetTimeSeconds();
+	}
+	updateEdgeEstimate();
+	processInputBuffer();
+
+	// the special moves step with the frame time at any frame rate: the claw and the profiles are evaluated in closed form
+	// from the state time and the character movement integrates the resulting velocity and gravity in its own substeps
+	updateSpecialMoves(DeltaTime);
+
+	refreshAnimSnapshot();
+}
+
+void USpecialMovementComponent::refreshAnimSnapshot()
+{
+	mAnimSnapshot.state = mState;
+	mAnimSnapshot.wallNormal = mWallNormal;
+	mAnimSnapshot.wallImpact = mWallImpact;
+	mAnimSnapshot.wallrunDir = mWallrunDir;
+	mAnimSnapshot.velocity = move->Velocity;
+	mAnimSnapshot.isFalling = move->IsFalling();
+}
+
+void USpecialMovementComponent::resetState()
+{
+	// the SLIDE exit hook restores the slide settings, the wallrun ones are restored below
+	endWallClaw();
+	switchState(ESpecialMovementState::NONE);
+
+	move->GravityScale = mDefaultGravityScale;
+	move->AirControl = mDefaultAirControl;
+	move->MaxWalkSpeed = mDefaultMaxWalkSpeed;
+	move->bOrientRotationToMovement = true;
+
+	if (cameraStick) {
+		cameraStick->bEnableCameraRotationLag = false;
+		cameraStick->bDoCollisionTest = mDefaultCameraCollisionTest;
+	}
+
+	mInputBufferStart = 0;
+	mInputBufferCount = 0;
+	mLastGroundTime = -1.0f;
+	mLastWallTime = -1.0f;
+	mJumpMidAirAllowed = false;
+	mWalljumpChain = 0;
+	mProfileTime = 0.0f;
+	mWallrunTurnRate = 0.0f;
+	mAnimSnapshot = FSpecialMovementAnimSnapshot();
+	resetEdgeEstimate();
+
+	resetWallrunPrevention();
+}
+
+void USpecialMovementComponent::captureSnapshot(FSpecialMovementSnapshot& outSnapshot) const
+{
+	float const now = GetWorld()->GetTimeSeconds();
+	FTimerManager const & timers = GetWorld()->GetTimerManager();
+
+	outSnapshot.state = mState;
+	outSnapshot.wallrunDir = mWallrunDir;
+	outSnapshot.wallNormal = mWallNormal;
+	outSnapshot.wallImpact = mWallImpact;
+	outSnapshot.wallrunSpeed = mWallrunSpeed;
+
+	outSnapshot.clawIntoWall = mClawIntoWall;
+	outSnapshot.clawZStartVelo = mClawZStartVelo;
+	outSnapshot.clawZTargetVelo = mClawZTargetVelo;
+	outSnapshot.clawSpeed = mClawSpeed;
+	outSnapshot.clawTime = mClawTime;
+
+	outSnapshot.jumpMidAirAllowed = mJumpMidAirAllowed;
+	outSnapshot.walljumpChain = mWalljumpChain;
+	outSnapshot.lastGroundAge = mLastGroundTime < 0.0f ? -1.0f : now - mLastGroundTime;
+	outSnapshot.lastWallAge = mLastWallTime < 0.0f ? -1.0f : now - mLastWallTime;
+	outSnapshot.lastWallState = mLastWallState;
+	outSnapshot.lastWallNormal = mLastWallNormal;
+
+	outSnapshot.stateAge = now - mStateEnterTime;
+	outSnapshot.profileTime = mProfileTime;
+
+	outSnapshot.wallrunPrevention = mWallrunPrevention;
+	outSnapshot.wallrunPreventionRemaining = timers.IsTimerActive(mWallrunPreventTimer) ? timers.GetTimerRemaining(mWallrunPreventTimer) : -1.0f;
+
+	outSnapshot.gravityScale = move->GravityScale;
+	outSnapshot.airControl = move->AirControl;
+	outSnapshot.maxWalkSpeed = move->MaxWalkSpeed;
+	outSnapshot.maxWalkSpeedCrouched = move->MaxWalkSpeedCrouched;
+	outSnapshot.groundFriction = move->GroundFriction;
+	outSnapshot.brakingDecelerationWalking = move->BrakingDecelerationWalking;
+	outSnapshot.orientRotationToMovement = move->bOrientRotationToMovement;
+	outSnapshot.planeConstraintNormal = move->GetPlaneConstraintNormal();
+	outSnapshot.cameraRotationLag = cameraStick ? cameraStick->bEnableCameraRotationLag : false;
+	outSnapshot.cameraCollisionTest = cameraStick ? cameraStick->bDoCollisionTest : mDefaultCameraCollisionTest;
+}
+
+void USpecialMovementComponent::restoreSnapshot(FSpecialMovementSnapshot const & snapshot)
+{
+	float const now = GetWorld()->GetTimeSeconds();
+
+	// the state is written directly, the enter and exit hooks would overwrite the restored settings below
+	mState = snapshot.state;
+	mWallrunDir = snapshot.wallrunDir;
+	mWallNormal = snapshot.wallNormal;
+	mWallImpact = snapshot.wallImpact;
+	mWallrunSpeed = snapshot.wallrunSpeed;
+	mWallrunTurnRate = 0.0f;
+
+	mClawIntoWall = snapshot.clawIntoWall;
+	mClawZStartVelo = snapshot.clawZStartVelo;
+	mClawZTargetVelo = snapshot.clawZTargetVelo;
+	mClawSpeed = snapshot.clawSpeed;
+	mClawTime = snapshot.clawTime;
+
+	mJumpMidAirAllowed = snapshot.jumpMidAirAllowed;
+	mWalljumpChain = snapshot.walljumpChain;
+	mLastGroundTime = snapshot.lastGroundAge < 0.0f ? -1.0f : now - snapshot.lastGroundAge;
+	mLastWallTime = snapshot.lastWallAge < 0.0f ? -1.0f : now - snapshot.lastWallAge;
+	mLastWallState = snapshot.lastWallState;
+	mLastWallNormal = snapshot.lastWallNormal;
+
+	mStateEnterTime = now - snapshot.stateAge;
+	mProfileTime = snapshot.profileTime;
+
+	resetWallrunPrevention();
+	mWallrunPrevention = snapshot.wallrunPrevention;
+	if (snapshot.wallrunPrevention && snapshot.wallrunPreventionRemaining > 0.0f) {
+		GetWorld()->GetTimerManager().SetTimer(mWallrunPreventTimer, this, &USpecialMovementComponent::resetWallrunPrevention, snapshot.wallrunPreventionRemaining);
+	}
+
+	move->GravityScale = snapshot.gravityScale;
+	move->AirControl = snapshot.airControl;
+	move->MaxWalkSpeed = snapshot.maxWalkSpeed;
+	move->MaxWalkSpeedCrouched = snapshot.maxWalkSpeedCrouched;
+	move->GroundFriction = snapshot.groundFriction;
+	move->BrakingDecelerationWalking = snapshot.brakingDecelerationWalking;
+	move->bOrientRotationToMovement = snapshot.orientRotationToMovement;
+	// only the slide constrains the movement to its floor plane
+	move->SetPlaneConstraintNormal(snapshot.planeConstraintNormal);
+	move->SetPlaneConstraintEnabled(snapshot.state == ESpecialMovementState::SLIDE);
+
+	if (cameraStick) {
+		cameraStick->bEnableCameraRotationLag = snapshot.cameraRotationLag;
+		cameraStick->bDoCollisionTest = snapshot.cameraCollisionTest;
+	}
+
+	mInputBufferStart = 0;
+	mInputBufferCount = 0;
+	resetEdgeEstimate();
+	refreshAnimSnapshot();
+}
+
+void USpecialMovementComponent::setLowDetail(bool lowDetail)
+{
+	mLowDetail = lowDetail;
+}
+
+void USpecialMovementComponent::bakeProfiles()
+{
+	mWallrunSpeedLUT.bake(mWallrunSpeedCurve);
+	mWallrunGravityLUT.bake(mWallrunGravityCurve);
+	mWallClawLUT.bake(mWallClawCurve);
+	mSlideDecelerationLUT.bake(mSlideDecelerationCurve);
+}
+
+void USpecialMovementComponent::updateSpecialMoves(float time)
+{
+	mProfileTime += time;
+
 	if (isWallrunning()) {
-		updateWallrun(DeltaTime);
+		updateWallrun(time);
 	}
 	else if (mState == ESpecialMovementState::SLIDE) {
-		updateSlide(DeltaTime);
+		updateSlide(time);
 	}
 }
 
@@ -81,6 +280,12 @@ void USpecialMovementComponent::OnLanded(const FHitResult& Hit)
 	ResetJump(0);
 	resetWallrunPrevention();
 	mJumpMidAirAllowed = false;
+	mLastWallTime = -1.0f;
+
+	if (mWalljumpChain > 0) {
+		ParkourTelemetry::record(EParkourTelemetryEvent::WALLJUMP_CHAIN, owner->GetUniqueID(), 0, mWalljumpChain);
+		mWalljumpChain = 0;
+	}
 }
 
 void USpecialMovementComponent::ResetJump(int new_jump_count)
@@ -90,27 +295,101 @@ void USpecialMovementComponent::ResetJump(int new_jump_count)
 
 void USpecialMovementComponent::Jump()
 {
+	bufferAction(EBufferedAction::JUMP);
+}
+
+void USpecialMovementComponent::Slide()
+{
+	bufferAction(EBufferedAction::SLIDE);
+}
+
+void USpecialMovementComponent::bufferAction(EBufferedAction action)
+{
+	float const now = GetWorld()->GetTimeSeconds();
+
+	// pressing again while the action is still pending only restarts its window
+	for (int32 i = 0; i < mInputBufferCount; i++) {
+		FBufferedInput& input = mInputBuffer[(mInputBufferStart + i) % InputBufferSize];
+		if (input.action == action) {
+			input.time = now;
+			processInputBuffer();
+			return;
+		}
+	}
+
+	if (mInputBufferCount == InputBufferSize) {
+		// drop the oldest press
+		mInputBufferStart = (mInputBufferStart + 1) % InputBufferSize;
+		mInputBufferCount--;
+	}
+	mInputBuffer[(mInputBufferStart + mInputBufferCount) % InputBufferSize] = { now, action };
+	mInputBufferCount++;
+
+	// try right away, most presses are performed on the frame they arrive
+	processInputBuffer();
+}
+
+void USpecialMovementComponent::processInputBuffer()
+{
+	float const now = GetWorld()->GetTimeSeconds();
+
+	// pop every press once, the ones that are neither performed nor expired are pushed back in order
+	int32 const count = mInputBufferCount;
+	for (int32 i = 0; i < count; i++) {
+		FBufferedInput const input = mInputBuffer[mInputBufferStart];
+		mInputBufferStart = (mInputBufferStart + 1) % InputBufferSize;
+		mInputBufferCount--;
+
+		float const window = input.action == EBufferedAction::JUMP ? mJumpBufferTime : mSlideBufferTime;
+		if (now - input.time > window) {
+			continue;
+		}
+
+		bool const performed = input.action == EBufferedAction::JUMP ? tryJump() : startSlide();
+		if (performed == false) {
+			mInputBuffer[(mInputBufferStart + mInputBufferCount) % InputBufferSize] = input;
+			mInputBufferCount++;
+		}
+	}
+}
+
+bool USpecialMovementComponent::tryJump()
+{
+	float const now = GetWorld()->GetTimeSeconds();
 	FVector launchVelo = FVector::ZeroVector;
+
 	if (isWallrunning()) {
 		// jump off wall
-		launchVelo = calcLaunchVelocity(false);
+		launchVelo = calcLaunchVelocity(makeLaunchQuery(false));
 		endWallrun(EWallrunEndReason::USER_JUMP);
 	}
+	else if (move->IsFalling() && now - mLastWallTime <= mCoyoteTime) {
+		// left the wall a moment ago, jump off it anyway
+		FLaunchQuery query = makeLaunchQuery(false);
+		query.state = mLastWallState;
+		query.wallNormal = mLastWallNormal;
+		launchVelo = calcLaunchVelocity(query);
+		onWalljump();
+	}
 	else if (owner->JumpCurrentCount < owner->JumpMaxCount) {
-		if (move->IsFalling() == false || mJumpMidAirAllowed) {
+		// walked off an edge a moment ago, jump as if still on the ground
+		bool const coyote = move->IsFalling() && owner->JumpCurrentCount == 0 && now - mLastGroundTime <= mCoyoteTime;
+		if (move->IsFalling() == false || coyote || mJumpMidAirAllowed) {
 			owner->JumpCurrentCount++;
-			launchVelo = calcLaunchVelocity(true);
+			FLaunchQuery query = makeLaunchQuery(true);
+			query.isFalling = query.isFalling && coyote == false;
+			launchVelo = calcLaunchVelocity(query);
 		}
 	}
 
-	if (launchVelo != FVector::ZeroVector) {
-		owner->LaunchCharacter(launchVelo, false, true);
+	if (launchVelo == FVector::ZeroVector) {
+		return false;
 	}
-}
 
-void USpecialMovementComponent::Slide()
-{
-	startSlide();
+	mLastGroundTime = -1.0f;
+	mLastWallTime = -1.0f;
+	owner->LaunchCharacter(launchVelo, false, true);
+	return true;
 }
 
 void USpecialMovementComponent::clampHorizontalVelocity(FVector & velocity, float const maxSpeed) const
@@ -130,17 +409,18 @@ bool USpecialMovementComponent::checkDirectionForWall(FHitResult& hit, FVector c
 	direction.Normalize();
 	direction *= traceLength;
 
-	if (mDebugWallrun) {
+	if (isDebugging(mDebugWallrun)) {
 		DrawDebugLine(GetWorld(), origin, origin + direction, FColor::Red, false, 40.0f, 0U, 5.0f);
 	}
 
-	return GetWorld()->LineTraceSingleByChannel(hit, origin, origin + direction, ECollisionChannel::ECC_WorldStatic, IGNORE_SELF_COLLISION_PARAM);
+	return GetWorld()->LineTraceSingleByChannel(hit, origin, origin + direction, ECollisionChannel::ECC_WorldStatic, mQueryParams);
 }
 
 void USpecialMovementComponent::startWallClaw(float speed, float targetZVelocity)
 {
 	mClawIntoWall = true;
 	mClawTime = 0.0f;
+	mClawZStartVelo = move->Velocity.Z;
 	mClawZTargetVelo = targetZVelocity;
 	mClawSpeed = speed;
 	move->GravityScale = 0.0f;
@@ -149,7 +429,7 @@ void USpecialMovementComponent::startWallClaw(float speed, float targetZVelocity
 void USpecialMovementComponent::endWallClaw()
 {
 	if (mClawIntoWall) {
-		if (mDebugWallrun) {
+		if (isDebugging(mDebugWallrun)) {
 			GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Green, "stopped claw into wall");
 		}
 		mClawIntoWall = false;
@@ -164,23 +444,22 @@ bool USpecialMovementComponent::isWallrunning(bool considerUp) const
 
 void USpecialMovementComponent::tryWallrun(const FHitResult& wallHit)
 {
+	LLM_SCOPE_BYTAG(Parkour);
+	PARKOUR_ALLOCATION_CHECK_SCOPE(TryWallrun);
+
 	if (mWallrunPrevention || isWallrunInputPressed() == false || move->IsFalling() == false) {
 		return;
 	}
 
 	if (isWallrunning()) {
 		if (surfaceIsWallrunPossible(wallHit.ImpactNormal)) {
-			if (mDebugWallrun) {
+			if (isDebugging(mDebugWallrun)) {
 				GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Yellow, FString::Printf(TEXT("hit something while wallrunning, check for blocking geometry.")));
 			}
 
 			// This wallhit has to get a corrected position because the impact might be on the other side of the player capsule
-			FHitResult correctedWallhit = wallHit;
-			correctedWallhit.ImpactPoint = mWallImpact + mWallrunDir * CAPSULE_RADIUS * 0.9f;
-			double angle = 0.0f;
-			if (isValidInnerOuterAngleDiff(move->GetActorLocation(), correctedWallhit, &angle)) {
-				addCameraRotation(FRotator(0.0f, angle, 0.0f));
-
+			FVector const correctedImpact = mWallImpact + mWallrunDir * CAPSULE_RADIUS * 0.9f;
+			if (isValidInnerOuterAngleDiff(move->GetActorLocation(), correctedImpact, wallHit.ImpactNormal)) {
 				mWallNormal = wallHit.ImpactNormal;
 				mWallImpact = wallHit.ImpactPoint;
 				mWallrunDir = calcWallrunDir(mWallNormal, mState);
@@ -194,7 +473,7 @@ void USpecialMovementComponent::tryWallrun(const FHitResult& wallHit)
 		}
 	}
 
-	if (mDebugWallrun) {
+	if (isDebugging(mDebugWallrun)) {
 		DrawDebugLine(GetWorld(), wallHit.ImpactPoint, wallHit.ImpactPoint + (wallHit.ImpactNormal * 100.0f), FColor::Yellow, false, 40.0f, 0U, 5.0f);
 	}
 
@@ -209,16 +488,15 @@ void USpecialMovementComponent::startWallrun(const FHitResult& wallHit)
 	mWallImpact = wallHit.ImpactPoint;
 	auto state = findWallrunSide(mWallNormal);
 	mWallrunDir = calcWallrunDir(mWallNormal, state);
+	mWallrunTurnRate = 0.0f;
 
-
-	FHitResult hit;
 	FVector side = owner->GetActorRightVector();
 	if (state == ESpecialMovementState::WALLRUN_LEFT) {
 		side *= -1.0f;
 	}
 
 	double const angle = calcAngleBetweenVectors(wallHit.ImpactNormal, -side);
-	if (mDebugWallrun) {
+	if (isDebugging(mDebugWallrun)) {
 		GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Purple, FString::Printf(TEXT("start wallrunning, angle: %f"), angle));
 
 	}
@@ -232,8 +510,12 @@ void USpecialMovementComponent::startWallrun(const FHitResult& wallHit)
 		return;
 	}
 
+	ParkourTelemetry::record(EParkourTelemetryEvent::WALLRUN_START, owner->GetUniqueID(), (uint8)state);
+
 	if (mCorrectCamera && cameraStick) {
 		cameraStick->bEnableCameraRotationLag = true;
+		// UParkourCameraModifier keeps the camera off the wall with the wall hit data, no probe needed
+		cameraStick->bDoCollisionTest = false;
 	}
 
 	// use current velocity or maxWalkSpeed for the wallrun
@@ -273,10 +555,14 @@ void USpecialMovementComponent::setWallrunPrevention(float timeToPrevent)
 
 void USpecialMovementComponent::endWallrun(EWallrunEndReason endReason)
 {
+	float const wallrunTime = getStateTime();
+	ESpecialMovementState const wallState = mState;
 	if (switchState(ESpecialMovementState::NONE) == false) {
 		return;
 	}
 
+	ParkourTelemetry::record(EParkourTelemetryEvent::WALLRUN_END, owner->GetUniqueID(), (uint8)endReason, wallrunTime);
+
 	// call endWallClaw before gravity reset because it does manipulate gravity as well
 	endWallClaw();
 
@@ -286,13 +572,13 @@ void USpecialMovementComponent::endWallrun(EWallrunEndReason endReason)
 
 	if (mCorrectCamera && cameraStick) {
 		cameraStick->bEnableCameraRotationLag = false;
+		cameraStick->bDoCollisionTest = mDefaultCameraCollisionTest;
 	}
 
 	mJumpMidAirAllowed = false;
 
 	if (endReason == USER_JUMP) {
-		ResetJump(owner->JumpCurrentCount - mRegainJumpsAfterWalljump);
-		mJumpMidAirAllowed = true;
+		onWalljump();
 		// TODO: this does not feel good, deactivated for now. Do we really need this?
 		// setWallrunPrevention(0.05f);
 	}
@@ -300,6 +586,20 @@ void USpecialMovementComponent::endWallrun(EWallrunEndReason endReason)
 		// prevent next wallrun until we hit the ground or timed out
 		setWallrunPrevention(0.5f);
 	}
+	else if (endReason == FALL_OFF || endReason == USER_STOP) {
+		// a jump shortly after still counts as walljump
+		mLastWallTime = GetWorld()->GetTimeSeconds();
+		mLastWallState = wallState;
+		mLastWallNormal = mWallNormal;
+	}
+}
+
+void USpecialMovementComponent::onWalljump()
+{
+	ResetJump(owner->JumpCurrentCount - mRegainJumpsAfterWalljump);
+	mJumpMidAirAllowed = true;
+	mWalljumpChain++;
+	ParkourTelemetry::record(EParkourTelemetryEvent::WALLJUMP, owner->GetUniqueID(), 0, mWalljumpChain);
 }
 
 void USpecialMovementComponent::updateWallrun(float time)
@@ -331,36 +631,49 @@ void USpecialMovementComponent::updateWallrun(float time)
 		}
 	}
 
-	double angle = 0.0f;
-	if (isValidInnerOuterAngleDiff(move->GetActorLocation(), hit, &angle) == false) {
+	if (isValidInnerOuterAngleDiff(move->GetActorLocation(), hit.ImpactPoint, hit.ImpactNormal) == false) {
 		// end wallrun with angle out of bounds to prevent a wallrunning loop in an inner corner.
 		endWallrun(EWallrunEndReason::ANGLE_OUT_OF_BOUNDS);
 		return;
 	}
-	addCameraRotation(FRotator(0.0f, angle, 0.0f));
 
+	FVector const previousDir = mWallrunDir;
 	mWallNormal = hit.ImpactNormal;
 	mWallImpact = hit.ImpactPoint;
 	mWallrunDir = calcWallrunDir(mWallNormal, mState);
+	// curvature of the wall, predictTrajectory keeps turning with it
+	mWallrunTurnRate = time > 0.0f ? FMath::FindDeltaAngleRadians(previousDir.HeadingAngle(), mWallrunDir.HeadingAngle()) / time : 0.0f;
+
+	// the character movement holds the speed and gravity scale set here over the whole next frame,
+	// sample the profiles in the middle of it, assuming it is as long as this one
+	float const profileTime = mProfileTime + time * 0.5f;
 
 	// set velocity according to the wall direction
-	if (mDebugWallrun) {
-		DrawDebugLine(GetWorld(), owner->GetActorLocation(), owner->GetActorLocation() + (mWallrunDir * mWallrunSpeed), FColor::Blue, false, -1.0f, 0U, 5.0f);
+	float const wallrunSpeed = mWallrunSpeed * mWallrunSpeedLUT.sample(profileTime);
+	if (isDebugging(mDebugWallrun)) {
+		DrawDebugLine(GetWorld(), owner->GetActorLocation(), owner->GetActorLocation() + (mWallrunDir * wallrunSpeed), FColor::Blue, false, -1.0f, 0U, 5.0f);
 	}
-	move->Velocity.X = mWallrunDir.X * mWallrunSpeed;
-	move->Velocity.Y = mWallrunDir.Y * mWallrunSpeed;
+	move->Velocity.X = mWallrunDir.X * wallrunSpeed;
+	move->Velocity.Y = mWallrunDir.Y * wallrunSpeed;
 
 	// manually calc velocity Z when clawing into the wall
 	if (mClawIntoWall) {
 		mClawTime += time;
-		if (mDebugWallrun) {
+		if (isDebugging(mDebugWallrun)) {
 			GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Green, FString::Printf(TEXT("mClawTime: %f, velo: %f, targetVelo: %f"), mClawTime, move->Velocity.Z, mClawZTargetVelo));
 		}
-		move->Velocity.Z = FMath::FInterpTo(move->Velocity.Z, mClawZTargetVelo, mClawTime, mClawSpeed);
-		if (move->Velocity.Z == mClawZTargetVelo) {
+		// claw duration = 1 / speed, the curve (or a quadratic ease out without one) blends over it.
+		// A function of the claw time only, so every frame rate sees the same velocity at the same time
+		float const clawAlpha = FMath::Min(mClawTime * mClawSpeed, 1.0f);
+		float const blend = mWallClawLUT.hasCurve() ? mWallClawLUT.sample(clawAlpha) : 1.0f - FMath::Square(1.0f - clawAlpha);
+		move->Velocity.Z = FMath::Lerp(mClawZStartVelo, mClawZTargetVelo, blend);
+		if (clawAlpha >= 1.0f) {
 			endWallClaw();
 		}
 	}
+	else {
+		move->GravityScale = mWallrunGravity * mWallrunGravityLUT.sample(profileTime);
+	}
 
 	// correct wallrun position
 	FVector positionCorrection = mWallImpact + mWallNormal * WALLRUN_REPLACEMENT - move->GetActorLocation();
@@ -372,44 +685,40 @@ void USpecialMovementComponent::updateWallrun(float time)
 
 bool USpecialMovementComponent::switchState(ESpecialMovementState newState)
 {
-	bool applyChange = true;
-	switch (newState) {
-	case ESpecialMovementState::WALLRUN_UP:
-		applyChange = mState == ESpecialMovementState::NONE ||
-			mState == ESpecialMovementState::SLIDE ||
-			mState == ESpecialMovementState::WALLRUN_LEFT ||
-			mState == ESpecialMovementState::WALLRUN_RIGHT;
-		break;
-
-	case ESpecialMovementState::WALLRUN_LEFT:
-	case ESpecialMovementState::WALLRUN_RIGHT:
-		applyChange = mState == ESpecialMovementState::NONE ||
-			mState == ESpecialMovementState::SLIDE ||
-			mState == ESpecialMovementState::WALLRUN_UP;
-		break;
+	if (canSwitchState(newState) == false) {
+		return false;
+	}
 
-	case ESpecialMovementState::SLIDE:
-		applyChange = mState == ESpecialMovementState::NONE;
-		break;
+	ESpecialMovementState const oldState = mState;
+	if (oldState == newState) {
+		return true;
+	}
 
-	case ESpecialMovementState::LEDGE_PULL:
-		applyChange = mState == ESpecialMovementState::ON_LEDGE;
-		break;
+	if (StateHooks[static_cast<uint8>(oldState)].onExit) {
+		(this->*StateHooks[static_cast<uint8>(oldState)].onExit)();
+	}
 
-	case ESpecialMovementState::ON_LEDGE:
-		applyChange = isWallrunning(true) || mState == ESpecialMovementState::NONE;
-		break;
+	mState = newState;
 
+	if (StateHooks[static_cast<uint8>(newState)].onEnter) {
+		(this->*StateHooks[static_cast<uint8>(newState)].onEnter)();
 	}
 
-	if (applyChange) {
-		if (mState == ESpecialMovementState::SLIDE && newState != ESpecialMovementState::NONE) {
-			endSlide(EWallrunEndReason::USER_STOP);
-		}
-		mState = newState;
-	}
+	ParkourTelemetry::record(EParkourTelemetryEvent::STATE_TIME, owner->GetUniqueID(), (uint8)oldState, getStateTime());
+	mStateEnterTime = GetWorld()->GetTimeSeconds();
+	mProfileTime = 0.0f;
 
-	return applyChange;
+	return true;
+}
+
+float USpecialMovementComponent::getStateTime() const
+{
+	return GetWorld()->GetTimeSeconds() - mStateEnterTime;
+}
+
+bool USpecialMovementComponent::canSwitchState(ESpecialMovementState newState) const
+{
+	return SpecialMovementTransitions::isAllowed(mState, newState);
 }
 
 FVector USpecialMovementComponent::calcWallrunDir(FVector wallNormal, ESpecialMovementState state)
@@ -447,72 +756,327 @@ bool USpecialMovementComponent::canJumpBoost() const
 	return move->IsFalling() == false && (mState == ESpecialMovementState::NONE || mState == ESpecialMovementState::SLIDE);
 }
 
-FVector USpecialMovementComponent::calcLaunchVelocity(bool jumpBoostEnabled) const
+void USpecialMovementComponent::updateEdgeEstimate()
+{
+	if (move->IsMovingOnGround() == false || move->CurrentFloor.IsWalkableFloor() == false) {
+		resetEdgeEstimate();
+		return;
+	}
+
+	// same probe distance as the old jump boost trace
+	FVector const movedir = owner->GetActorForwardVector();
+	FVector const location = move->GetActorLocation();
+	float const probeDistance = CAPSULE_RADIUS * 2.5f;
+	FHitResult const & floorHit = move->CurrentFloor.HitResult;
+
+	// perched: the floor sweep only touches a rim behind the capsule center, the character already stands over the edge.
+	// on a rim the sweep normal differs from the surface normal, on a plain slope they are the same.
+	FVector2D const floorOffset(floorHit.ImpactPoint - location);
+	bool const onRim = FVector::Coincident(floorHit.Normal, floorHit.ImpactNormal) == false;
+	if (onRim && FVector2D::DotProduct(floorOffset, FVector2D(movedir)) < -FMath::Max(move->PerchRadiusThreshold, 1.0f)) {
+		mOnJumpBoostEdge = true;
+		mEdgeProbeValid = false;
+		return;
+	}
+
+	// far from the border of a box shaped floor, nothing can drop away in front of the character
+	UPrimitiveComponent* floor = floorHit.GetComponent();
+	if (floor && calcFloorExitDistance(floor, location, movedir) > probeDistance) {
+		mOnJumpBoostEdge = false;
+		mEdgeProbeValid = false;
+		return;
+	}
+
+	// close to the border or any other floor shape, the floor might end or continue on a neighbouring primitive.
+	// Reuse the last probe while it still covers the spot.
+	FVector const probeOrigin = location + movedir * probeDistance;
+	float const reprobeDistance = CAPSULE_RADIUS * 0.25f;
+	if (mEdgeProbeValid && FVector::DistSquared(probeOrigin, mEdgeProbeLocation) < reprobeDistance * reprobeDistance) {
+		return;
+	}
+
+	mOnJumpBoostEdge = probeJumpBoostEdge(probeOrigin);
+	mEdgeProbeLocation = probeOrigin;
+	mEdgeProbeValid = true;
+}
+
+float USpecialMovementComponent::calcFloorExitDistance(UPrimitiveComponent* floor, FVector const & location, FVector const & dir)
+{
+	if (mEdgeFloor.Get() != floor) {
+		mEdgeFloor = floor;
+		mEdgeFloorLocalBox = calcFloorCollisionBox(floor);
+		mEdgeProbeValid = false;
+	}
+
+	// holes, merged meshes, stairs or landscape: the bounds say nothing about where the floor ends
+	if (mEdgeFloorLocalBox.IsValid == false) {
+		return 0.0f;
+	}
+
+	// horizontal slab test against the collision box of the floor
+	FTransform const & transform = floor->GetComponentTransform();
+	FVector const localLocation = transform.InverseTransformPosition(location);
+	FVector const localDir = transform.InverseTransformVector(dir);
+
+	float exitTime = TNumericLimits<float>::Max();
+	for (int32 axis = 0; axis < 2; axis++) {
+		if (FMath::Abs(localDir[axis]) > SMALL_NUMBER) {
+			float const border = localDir[axis] > 0.0f ? mEdgeFloorLocalBox.Max[axis] : mEdgeFloorLocalBox.Min[axis];
+			exitTime = FMath::Min(exitTime, (border - localLocation[axis]) / localDir[axis]);
+		}
+	}
+
+	// back to world units, the inverse transform scaled the direction
+	float const localDirLength = localDir.Size();
+	return localDirLength > SMALL_NUMBER ? exitTime * localDirLength : exitTime;
+}
+
+FBox USpecialMovementComponent::calcFloorCollisionBox(UPrimitiveComponent const* floor)
+{
+	if (UBoxComponent const* box = Cast<UBoxComponent>(floor)) {
+		FVector const extent = box->GetUnscaledBoxExtent();
+		return FBox(-extent, extent);
+	}
+
+	UStaticMeshComponent const* meshComponent = Cast<UStaticMeshComponent>(floor);
+	UStaticMesh const* mesh = meshComponent ? meshComponent->GetStaticMesh() : nullptr;
+	UBodySetup const* bodySetup = mesh ? mesh->GetBodySetup() : nullptr;
+	if (bodySetup == nullptr || bodySetup->GetCollisionTraceFlag() == CTF_UseComplexAsSimple) {
+		return FBox(ForceInit);
+	}
+
+	// exactly one axis aligned box and nothing else
+	FKAggregateGeom const & geom = bodySetup->AggGeom;
+	if (geom.GetElementCount() != 1 || geom.BoxElems.Num() != 1 || geom.BoxElems[0].Rotation.IsNearlyZero() == false) {
+		return FBox(ForceInit);
+	}
+
+	FKBoxElem const & elem = geom.BoxElems[0];
+	return FBox::BuildAABB(elem.Center, FVector(elem.X, elem.Y, elem.Z) * 0.5f);
+}
+
+bool USpecialMovementComponent::probeJumpBoostEdge(FVector const & probeOrigin) const
+{
+	float const length = owner->GetCapsuleComponent()->GetScaledCapsuleHalfHeight() + move->MaxStepHeight * 2.0f;
+
+	FHitResult hit;
+	bool const onEdge = false == GetWorld()->LineTraceSingleByChannel(hit, probeOrigin, probeOrigin - FVector(0.0f, 0.0f, length), ECollisionChannel::ECC_WorldStatic, mQueryParams);
+
+	if (isDebugging(mDebugJump)) {
+		DrawDebugLine(GetWorld(), probeOrigin, probeOrigin - FVector(0.0f, 0.0f, length), onEdge ? FColor::Green : FColor::Red, false, 1.0f, 0U, 5.0f);
+	}
+
+	return onEdge;
+}
+
+void USpecialMovementComponent::resetEdgeEstimate()
+{
+	mEdgeFloor.Reset();
+	mEdgeProbeValid = false;
+	mOnJumpBoostEdge = false;
+}
+
+FLaunchQuery USpecialMovementComponent::makeLaunchQuery(bool checkJumpBoost) const
+{
+	FLaunchQuery query;
+	query.location = move->GetActorLocation();
+	query.velocity = move->Velocity;
+	query.state = mState;
+	query.wallNormal = mWallNormal;
+	// owner->GetActorRightAxis might be in forwardvector direction because bOrientToMovement and viceversa, use camera instead
+	query.inputDir = mRightAxis * camera->GetRightVector() + mForwardAxis * camera->GetForwardVector();
+	query.isFalling = move->IsFalling();
+	query.jumpBoost = checkJumpBoost && canJumpBoost() && isOnJumpBoostEdge();
+	return query;
+}
+
+FVector USpecialMovementComponent::calcLaunchVelocity(FLaunchQuery const & query) const
+{
+	if (query.jumpBoost) {
+		ParkourTelemetry::record(EParkourTelemetryEvent::JUMP_BOOST, owner->GetUniqueID(), 0, FVector2D(query.velocity).Length());
+
+		if (isDebugging(mDebugJump)) {
+			GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Green, FString::Printf(TEXT("JUMP BOOST RECEIVED!")));
+		}
+	}
+
+	FVector const launchDir = predictLaunchVelocity(query);
+
+	if (isDebugging(mDebugJump)) {
+		DrawDebugLine(GetWorld(), owner->GetActorLocation(), owner->GetActorLocation() + launchDir, FColor::Green, false, 40.0f, 0U, 5.0f);
+		GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Red, FString::Printf(TEXT("IsFalling % d, launchDir %s"), move->IsFalling(), *launchDir.ToString()));
+	}
+
+	return launchDir;
+}
+
+FVector USpecialMovementComponent::predictLaunchVelocity(FLaunchQuery const & query) const
 {
 	FVector launchDir(0, 0, 0);
 	bool clampVelo = true;
 
-	if (isWallrunning()) {
-		switch (mState) {
-		case ESpecialMovementState::WALLRUN_LEFT:
-		case ESpecialMovementState::WALLRUN_RIGHT:
-		case ESpecialMovementState::WALLRUN_UP:
-			launchDir = mWallNormal;
-			launchDir.Normalize();
-			launchDir *= move->JumpZVelocity;
-			break;
-		}
+	if (query.state == ESpecialMovementState::WALLRUN_LEFT || query.state == ESpecialMovementState::WALLRUN_RIGHT) {
+		launchDir = query.wallNormal;
+		launchDir.Normalize();
+		launchDir *= move->JumpZVelocity;
 	}
-	else if (move->IsFalling()) {
-		// owner->GetActorRightAxis might be in forwardvector direction because bOrientToMovement and viceversa, use camera instead
-		launchDir = mRightAxis * camera->GetRightVector() + mForwardAxis * camera->GetForwardVector();
+	else if (query.isFalling) {
+		launchDir = query.inputDir;
 		launchDir.Normalize();
 		launchDir *= move->JumpZVelocity;
 	}
-	else if (jumpBoostEnabled && canJumpBoost()) {
-		// Jumpboost: check for a close edge
-		FVector movedir = owner->GetActorForwardVector();
-		float const length = owner->GetCapsuleComponent()->GetScaledCapsuleHalfHeight() + move->MaxStepHeight * 2.0f;
-		float const tolerance = CAPSULE_RADIUS * 1.5f;
-		// capsule radius is needed to offset from the center the actor
-		FVector traceDownOrigin = move->GetActorLocation() + movedir * (CAPSULE_RADIUS + tolerance);
-
-		FHitResult hit;
-		bool onEdge = false == GetWorld()->LineTraceSingleByChannel(hit, traceDownOrigin, traceDownOrigin - FVector(0.0f, 0.0f, length), ECollisionChannel::ECC_WorldStatic, IGNORE_SELF_COLLISION_PARAM);
-
-		if (mDebugJump) {
-			FColor debugCol = onEdge ? FColor::Green : FColor::Red;
-			DrawDebugLine(GetWorld(), traceDownOrigin, traceDownOrigin - FVector(0.0f, 0.0f, length), debugCol, false, 100.0f, 0U, 5.0f);
-			if (onEdge) {
-				GEngine->AddOnScreenDebugMessage(-1, 15.0f, debugCol, FString::Printf(TEXT("JUMP BOOST RECEIVED!")));
-			}
-		}
-
-		if (onEdge) {
-			// boost by multiplier - 1.0f to offset for the current velocity
-			launchDir.X = move->Velocity.X * (mJumpBoostMultiplier - 1.0f);
-			launchDir.Y = move->Velocity.Y * (mJumpBoostMultiplier - 1.0f);
-		}
+	else if (query.jumpBoost) {
+		// boost by multiplier - 1.0f to offset for the current velocity
+		launchDir.X = query.velocity.X * (mJumpBoostMultiplier - 1.0f);
+		launchDir.Y = query.velocity.Y * (mJumpBoostMultiplier - 1.0f);
 		clampVelo = false;
 	}
 
 	if (clampVelo) {
 		// do not gain more than the current horizontal velocity
-		FVector launchVelo = move->Velocity + launchDir;
-		float const currentHorizontalSpeed = FVector2D(move->Velocity).Length();
+		FVector launchVelo = query.velocity + launchDir;
+		float const currentHorizontalSpeed = FVector2D(query.velocity).Length();
 		clampHorizontalVelocity(launchVelo, currentHorizontalSpeed);
 
-		launchDir = launchVelo - move->Velocity;
+		launchDir = launchVelo - query.velocity;
 	}
 
 	launchDir.Z = move->JumpZVelocity;
 
-	if (mDebugJump) {
-		DrawDebugLine(GetWorld(), owner->GetActorLocation(), owner->GetActorLocation() + launchDir, FColor::Green, false, 40.0f, 0U, 5.0f);
-		GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Red, FString::Printf(TEXT("IsFalling % d, launchDir %s"), move->IsFalling(), *launchDir.ToString()));
+	return launchDir;
+}
+
+void USpecialMovementComponent::predictLaunchArcs(TArray<FLaunchQuery> const & queries, TArray<FLaunchArcPrediction>& outArcs, float maxTime, float timeStep) const
+{
+	constexpr int32 MaxSteps = 256;
+
+	outArcs.SetNum(queries.Num());
+	if (queries.Num() == 0 || timeStep <= 0.0f) {
+		return;
 	}
 
-	return launchDir;
+	// every special move ends with the jump, so the arc uses the default movement settings
+	float const gravityZ = GetWorld()->GetGravityZ() * mDefaultGravityScale;
+	float const airAcceleration = move->GetMaxAcceleration() * mDefaultAirControl;
+	float const maxAirSpeed = move->MaxWalkSpeed;
+	int32 const numSteps = FMath::Min(FMath::CeilToInt(maxTime / timeStep), MaxSteps);
+
+	FCollisionShape const capsule = owner->GetCapsuleComponent()->GetCollisionShape();
+	FCollisionQueryParams const & params = mQueryParams;
+	UWorld const* world = GetWorld();
+
+	// an arc with acceleration a bulges at most a * T^2 / 8 (the sagitta) away from the chord over T.
+	// Chords are sized so that stays below half the capsule radius and are swept with the capsule inflated by it,
+	// so a chord never misses a ceiling, overhang or lip the arc itself would touch
+	float const acceleration = FVector2D(airAcceleration, gravityZ).Size();
+	float const maxSagitta = capsule.GetCapsuleRadius() * 0.5f;
+	float const chordTime = acceleration > SMALL_NUMBER ? FMath::Sqrt(8.0f * maxSagitta / acceleration) : maxTime;
+	int32 const segmentSteps = FMath::Clamp(FMath::FloorToInt(chordTime / timeStep), 1, MaxSteps);
+	float const sagitta = acceleration * FMath::Square(segmentSteps * timeStep) / 8.0f;
+	FCollisionShape const chordCapsule = FCollisionShape::MakeCapsule(capsule.GetCapsuleRadius() + sagitta, capsule.GetCapsuleHalfHeight() + sagitta);
+
+	// scene queries only take a read lock, so the sweeps of all arcs can run on worker threads
+	ParallelFor(queries.Num(), [&](int32 index) {
+		FLaunchQuery const & query = queries[index];
+		FLaunchArcPrediction& arc = outArcs[index];
+
+		arc.launchVelocity = predictLaunchVelocity(query);
+		arc.hit = false;
+		arc.airTime = 0.0f;
+		arc.landingHit = FHitResult();
+		arc.points.Reset(numSteps + 1);
+
+		// LaunchCharacter overrides Z but adds XY
+		FVector velocity(query.velocity.X + arc.launchVelocity.X, query.velocity.Y + arc.launchVelocity.Y, arc.launchVelocity.Z);
+		FVector const airInput = FVector(query.inputDir.X, query.inputDir.Y, 0.0f).GetClampedToMaxSize(1.0f) * airAcceleration;
+		float const maxHorizontalSpeed = FMath::Max(FVector2D(velocity).Length(), maxAirSpeed);
+
+		// integrate the whole arc first, the points are cheap compared to the sweeps
+		arc.points.Add(query.location);
+		for (int32 step = 0; step < numSteps; step++) {
+			velocity += (airInput + FVector(0.0f, 0.0f, gravityZ)) * timeStep;
+			clampHorizontalVelocity(velocity, maxHorizontalSpeed);
+			arc.points.Add(arc.points.Last() + velocity * timeStep);
+		}
+
+		// sweep coarse chords, only a chord that hits something is swept again step by step
+		for (int32 segmentStart = 0; segmentStart < numSteps; segmentStart += segmentSteps) {
+			int32 const segmentEnd = FMath::Min(segmentStart + segmentSteps, numSteps);
+			FHitResult hit;
+			if (segmentSteps > 1 && world->SweepSingleByChannel(hit, arc.points[segmentStart], arc.points[segmentEnd], FQuat::Identity, ECollisionChannel::ECC_WorldStatic, chordCapsule, params) == false) {
+				continue;
+			}
+
+			for (int32 step = segmentStart; step < segmentEnd; step++) {
+				if (world->SweepSingleByChannel(arc.landingHit, arc.points[step], arc.points[step + 1], FQuat::Identity, ECollisionChannel::ECC_WorldStatic, capsule, params)) {
+					arc.hit = true;
+					arc.airTime = timeStep * (step + arc.landingHit.Time);
+					arc.points.SetNum(step + 1, false);
+					arc.points.Add(arc.landingHit.Location);
+					return;
+				}
+			}
+			// the inflated chord came close to something the arc itself clears
+		}
+
+		arc.airTime = timeStep * numSteps;
+	});
+}
+
+void USpecialMovementComponent::predictTrajectory(float const* times, int32 numTimes, FVector* outOffsets) const
+{
+	constexpr float MaxStep = 1.0f / 30.0f;
+
+	FVector const acceleration = move->GetCurrentAcceleration();
+	bool const wallrunning = mState == ESpecialMovementState::WALLRUN_LEFT || mState == ESpecialMovementState::WALLRUN_RIGHT;
+	bool const onLedge = mState == ESpecialMovementState::ON_LEDGE || mState == ESpecialMovementState::LEDGE_PULL;
+	float const gravityZ = move->GetGravityZ();
+
+	FVector velocity = move->Velocity;
+	FVector wallrunDir = mWallrunDir;
+	FVector offset = FVector::ZeroVector;
+	float time = 0.0f;
+
+	// times are ascending, integrate in short steps up to each of them
+	for (int32 i = 0; i < numTimes; i++) {
+		while (time < times[i] - KINDA_SMALL_NUMBER) {
+			float const dt = FMath::Min(MaxStep, times[i] - time);
+
+			if (wallrunning) {
+				// keep turning with the wall at the speed of the profile
+				wallrunDir = wallrunDir.RotateAngleAxis(FMath::RadiansToDegrees(mWallrunTurnRate * dt), FVector::UpVector);
+				float const speed = mWallrunSpeed * mWallrunSpeedLUT.sample(mProfileTime + time);
+				velocity.X = wallrunDir.X * speed;
+				velocity.Y = wallrunDir.Y * speed;
+				velocity.Z += gravityZ * dt;
+			}
+			else if (onLedge) {
+				velocity = FVector::ZeroVector;
+			}
+			else if (mState == ESpecialMovementState::SLIDE) {
+				// the slide only brakes, it is constrained to the floor plane
+				float const deceleration = mSlideDeceleration * mSlideDecelerationLUT.sample(mProfileTime + time);
+				velocity = velocity.GetSafeNormal() * FMath::Max(velocity.Size() - deceleration * dt, 0.0f);
+			}
+			else if (move->IsFalling()) {
+				// launch arc, steered by the input through air control
+				velocity += FVector(acceleration.X, acceleration.Y, 0.0f) * move->AirControl * dt;
+				velocity.Z += gravityZ * dt;
+			}
+			else {
+				// on the ground the velocity turns toward the input or brakes without one
+				bool const braking = acceleration.IsNearlyZero();
+				FVector const target = braking ? FVector::ZeroVector : acceleration.GetSafeNormal2D() * move->GetMaxSpeed();
+				float const rate = braking ? move->GetMaxBrakingDeceleration() : move->GetMaxAcceleration();
+				velocity = FMath::VInterpConstantTo(velocity, target, dt, rate);
+			}
+
+			offset += velocity * dt;
+			time += dt;
+		}
+
+		outOffsets[i] = offset;
+	}
 }
 
 bool USpecialMovementComponent::surfaceIsWallrunPossible(FVector surfaceNormal) const
@@ -535,39 +1099,28 @@ double USpecialMovementComponent::calcAngleBetweenVectors(FVector a, FVector b)
 }
 
 
-bool USpecialMovementComponent::isValidInnerOuterAngleDiff(FVector const & origin, const FHitResult& hit, double * angleOut)
+bool USpecialMovementComponent::isValidInnerOuterAngleDiff(FVector const & origin, FVector const & impactPoint, FVector const & impactNormal)
 {
-	FVector const hitdirection = FVector::CrossProduct(hit.ImpactNormal, FVector(0, 0, mState == ESpecialMovementState::WALLRUN_LEFT ? 1 : -1));
+	FVector const hitdirection = FVector::CrossProduct(impactNormal, FVector(0, 0, mState == ESpecialMovementState::WALLRUN_LEFT ? 1 : -1));
 	double const angle = calcAngleBetweenVectors(mWallrunDir, hitdirection);
 
 	// inner / outer angle determination taken from: https://stackoverflow.com/questions/12397564/check-if-an-angle-defined-by-3-points-is-inner-or-outer
 	// Describe the two angle vectors coming from the center point as a and b. And describe the vector from your center point to the origin as center.
-	FVector const center = origin - hit.ImpactPoint;
+	FVector const center = origin - impactPoint;
 	FVector const a = -mWallrunDir;
 	FVector const b = hitdirection;
 	bool const isInnerAngle = (FVector::DotProduct(a + b, center) > 0.0 && FVector::DotProduct(FVector::CrossProduct(a, center), FVector::CrossProduct(b, center)) < 0.0);
 
 	float maxAngle = isInnerAngle? mMaxWallrunInnerAngle : mMaxWallrunOuterAngle;
 
-	if (mDebugWallrun && angle > 0.005f) {
+	if (isDebugging(mDebugWallrun) && angle > 0.005f) {
 		FColor debugCol = isInnerAngle ? FColor::Yellow : FColor::Green;
-		DrawDebugLine(GetWorld(), hit.ImpactPoint + a * 100, hit.ImpactPoint, debugCol, false, 100.0f, 0U, 5.0f);
-		DrawDebugLine(GetWorld(), hit.ImpactPoint + b * 100, hit.ImpactPoint, debugCol, false, 100.0f, 0U, 5.0f);
+		DrawDebugLine(GetWorld(), impactPoint + a * 100, impactPoint, debugCol, false, 100.0f, 0U, 5.0f);
+		DrawDebugLine(GetWorld(), impactPoint + b * 100, impactPoint, debugCol, false, 100.0f, 0U, 5.0f);
 		DrawDebugCrosshairs(GetWorld(), origin, FRotator::ZeroRotator, 30.0f, FColor::Blue, false, 100.0f, 0U);
 		GEngine->AddOnScreenDebugMessage(-1, 15.0f, debugCol, FString::Printf(TEXT("angle: %f"), angle));
 	}
 
-	if (angleOut) {
-		if ((isInnerAngle && mState == ESpecialMovementState::WALLRUN_LEFT) ||
-			(isInnerAngle == false && mState == ESpecialMovementState::WALLRUN_RIGHT)) {
-
-			*angleOut = angle;
-		}
-		else {
-			*angleOut = -angle;
-		}
-	}
-
 	if (angle > maxAngle) {
 		return false;
 	}
@@ -575,19 +1128,6 @@ bool USpecialMovementComponent::isValidInnerOuterAngleDiff(FVector const & origi
 	return true;
 }
 
-void USpecialMovementComponent::addCameraRotation(FRotator const & addRotation)
-{
-	if (mCorrectCamera == false) {
-		return;
-	}
-
-	AController* controller = owner->GetController();
-	if (controller) {
-		FRotator const currentRotation = controller->GetControlRotation();
-		controller->SetControlRotation(currentRotation + addRotation);
-	}
-}
-
 bool USpecialMovementComponent::canSlide()
 {
 	if (move->IsFalling() || move->CurrentFloor.IsWalkableFloor() == false || mState != ESpecialMovementState::NONE) {
@@ -596,14 +1136,14 @@ bool USpecialMovementComponent::canSlide()
 	return true;
 }
 
-void USpecialMovementComponent::startSlide()
+bool USpecialMovementComponent::startSlide()
 {
 	if (canSlide() == false) {
-		return;
+		return false;
 	}
 
 	if (switchState(ESpecialMovementState::SLIDE) == false) {
-		return;
+		return false;
 	}
 
 	// addImpulse in the direction of the current floor
@@ -617,12 +1157,12 @@ void USpecialMovementComponent::startSlide()
 	if (move->Velocity.Length() <= move->MaxWalkSpeed * 1.2f) {
 		move->AddImpulse(launchInFloorDirection, true);
 
-		if (mDebugSlide) {
+		if (isDebugging(mDebugSlide)) {
 			GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Cyan, FString::Printf(TEXT("started slide dir: %s"), *launchInFloorDirection.ToString()));
 			DrawDebugLine(GetWorld(), owner->GetActorLocation(), owner->GetActorLocation() + launchInFloorDirection, FColor::Cyan, false, 100.0f, 0U, 5.0f);
 		}
 	}
-	else if (mDebugSlide) {
+	else if (isDebugging(mDebugSlide)) {
 		DrawDebugLine(GetWorld(), owner->GetActorLocation(), owner->GetActorLocation() + move->Velocity, FColor::Orange, false, 100.0f, 0U, 5.0f);
 	}
 
@@ -634,13 +1174,18 @@ void USpecialMovementComponent::startSlide()
 
 	move->SetPlaneConstraintFromVectors(launchInFloorDirection, FloorNormal);
 	move->SetPlaneConstraintEnabled(true);
+	return true;
 }
 
 void USpecialMovementComponent::endSlide(EWallrunEndReason endReason)
 {
-	if (switchState(ESpecialMovementState::NONE) == false) {
-		return;
-	}
+	// the slide settings are reset by the SLIDE exit hook
+	switchState(ESpecialMovementState::NONE);
+}
+
+void USpecialMovementComponent::exitSlide()
+{
+	ParkourTelemetry::record(EParkourTelemetryEvent::SLIDE_END, owner->GetUniqueID(), 0, getStateTime());
 
 	owner->UnCrouch();
 	move->MaxWalkSpeedCrouched = mDefaultMaxWalkSpeedCrouched;
@@ -653,15 +1198,18 @@ void USpecialMovementComponent::endSlide(EWallrunEndReason endReason)
 
 void USpecialMovementComponent::updateSlide(float time)
 {
+	// held by the character movement over the next frame, sampled in the middle of it like the wallrun profiles
+	move->BrakingDecelerationWalking = mSlideDeceleration * mSlideDecelerationLUT.sample(mProfileTime + time * 0.5f);
+
 	if (move->IsFalling() || move->CurrentFloor.IsWalkableFloor() == false ) {
-		if (mDebugSlide) {
+		if (isDebugging(mDebugSlide)) {
 			GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Cyan, FString::Printf(TEXT("stopped slide. reason: in air")));
 		}
 		endSlide(EWallrunEndReason::FALL_OFF);
 	}
 
 	if (move->Velocity.Length() < move->MaxWalkSpeed * 0.9f) {
-		if (mDebugSlide) {
+		if (isDebugging(mDebugSlide)) {
 			GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Cyan, FString::Printf(TEXT("stopped slide. reason: velocity too low")));
 		}
 		endSlide(EWallrunEndReason::ANGLE_OUT_OF_BOUNDS);
@@ -4,6 +4,8 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "CollisionQueryParams.h"
+#include "CurveLUT.h"
 #include "SpecialMovementComponent.generated.h"
 
 UENUM(BlueprintType)
@@ -15,7 +17,182 @@ enum class ESpecialMovementState : uint8
 	WALLRUN_UP		UMETA(DisplayName = "Wallrun Up"),
 	SLIDE			UMETA(DisplayName = "Slide"),
 	ON_LEDGE		UMETA(DisplayName = "On Ledge"),
-	LEDGE_PULL		UMETA(DisplayName = "Ledge Pull")
+	LEDGE_PULL		UMETA(DisplayName = "Ledge Pull"),
+
+	MAX				UMETA(Hidden)
+};
+
+namespace SpecialMovementTransitions
+{
+	constexpr int32 NumStates = static_cast<int32>(ESpecialMovementState::MAX);
+
+	constexpr uint32 toMask(ESpecialMovementState state)
+	{
+		return 1u << static_cast<uint32>(state);
+	}
+
+	/* Allowed[from] is a bitmask of all states that can be entered from the state 'from'. Sized by its rows, see the row count check below. */
+	constexpr uint32 Allowed[] =
+	{
+		/* NONE */
+		toMask(ESpecialMovementState::NONE) | toMask(ESpecialMovementState::WALLRUN_LEFT) | toMask(ESpecialMovementState::WALLRUN_RIGHT) |
+		toMask(ESpecialMovementState::WALLRUN_UP) | toMask(ESpecialMovementState::SLIDE) | toMask(ESpecialMovementState::ON_LEDGE),
+		/* WALLRUN_LEFT */
+		toMask(ESpecialMovementState::NONE) | toMask(ESpecialMovementState::WALLRUN_UP) | toMask(ESpecialMovementState::ON_LEDGE),
+		/* WALLRUN_RIGHT */
+		toMask(ESpecialMovementState::NONE) | toMask(ESpecialMovementState::WALLRUN_UP) | toMask(ESpecialMovementState::ON_LEDGE),
+		/* WALLRUN_UP */
+		toMask(ESpecialMovementState::NONE) | toMask(ESpecialMovementState::WALLRUN_LEFT) | toMask(ESpecialMovementState::WALLRUN_RIGHT) |
+		toMask(ESpecialMovementState::ON_LEDGE),
+		/* SLIDE */
+		toMask(ESpecialMovementState::NONE) | toMask(ESpecialMovementState::WALLRUN_LEFT) | toMask(ESpecialMovementState::WALLRUN_RIGHT) |
+		toMask(ESpecialMovementState::WALLRUN_UP),
+		/* ON_LEDGE */
+		toMask(ESpecialMovementState::NONE) | toMask(ESpecialMovementState::LEDGE_PULL),
+		/* LEDGE_PULL */
+		toMask(ESpecialMovementState::NONE)
+	};
+
+	static_assert(NumStates <= 32, "transition masks are stored in 32 bits");
+	static_assert(UE_ARRAY_COUNT(Allowed) == NumStates, "every state needs exactly one row in the transition table");
+
+	constexpr bool isAllowed(ESpecialMovementState from, ESpecialMovementState to)
+	{
+		return (Allowed[static_cast<uint8>(from)] & toMask(to)) != 0;
+	}
+
+	constexpr bool canAllReturnToNone()
+	{
+		for (int32 from = 0; from < NumStates; from++) {
+			if (isAllowed(static_cast<ESpecialMovementState>(from), ESpecialMovementState::NONE) == false) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static_assert(canAllReturnToNone(), "every state has to be able to return to NONE");
+	static_assert(isAllowed(ESpecialMovementState::SLIDE, ESpecialMovementState::SLIDE) == false && isAllowed(ESpecialMovementState::WALLRUN_LEFT, ESpecialMovementState::WALLRUN_LEFT) == false,
+		"special moves can not be restarted while active");
+	static_assert(isAllowed(ESpecialMovementState::NONE, ESpecialMovementState::LEDGE_PULL) == false && isAllowed(ESpecialMovementState::WALLRUN_LEFT, ESpecialMovementState::LEDGE_PULL) == false,
+		"ledge pull is only reachable from a ledge");
+}
+
+/* Copy of the special movement state read by animation and the camera, refreshed at the end of every tick. */
+struct FSpecialMovementAnimSnapshot
+{
+	ESpecialMovementState state = ESpecialMovementState::NONE;
+	FVector wallNormal = FVector::ZeroVector;
+	FVector wallImpact = FVector::ZeroVector;
+	FVector wallrunDir = FVector::ZeroVector;
+	FVector velocity = FVector::ZeroVector;
+	bool isFalling = false;
+};
+
+/*
+ * Complete runtime state of USpecialMovementComponent together with the movement and camera settings the special moves change.
+ * Plain data: captured at a checkpoint and restored within a frame without allocations. World times are stored as ages relative to the capture.
+ */
+struct FSpecialMovementSnapshot
+{
+	ESpecialMovementState state;
+	FVector wallrunDir;
+	FVector wallNormal;
+	FVector wallImpact;
+	float wallrunSpeed;
+
+	bool clawIntoWall;
+	float clawZStartVelo;
+	float clawZTargetVelo;
+	float clawSpeed;
+	float clawTime;
+
+	bool jumpMidAirAllowed;
+	int32 walljumpChain;
+	float lastGroundAge;
+	float lastWallAge;
+	ESpecialMovementState lastWallState;
+	FVector lastWallNormal;
+
+	float stateAge;
+	float profileTime;
+
+	bool wallrunPrevention;
+	float wallrunPreventionRemaining;
+
+	float gravityScale;
+	float airControl;
+	float maxWalkSpeed;
+	float maxWalkSpeedCrouched;
+	float groundFriction;
+	float brakingDecelerationWalking;
+	bool orientRotationToMovement;
+	FVector planeConstraintNormal;
+	bool cameraRotationLag;
+	bool cameraCollisionTest;
+};
+static_assert(std::is_trivially_copyable<FSpecialMovementSnapshot>::value, "checkpoints are copied around as plain data");
+
+/* Actions that are buffered until the special moves can perform them. */
+enum class EBufferedAction : uint8
+{
+	JUMP,
+	SLIDE
+};
+
+/* Character state to predict a launch (jump, walljump or jump boost) for. */
+USTRUCT(BlueprintType)
+struct FLaunchQuery
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Launch)
+	FVector location = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Launch)
+	FVector velocity = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Launch)
+	ESpecialMovementState state = ESpecialMovementState::NONE;
+
+	/* Only used while wallrunning. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Launch)
+	FVector wallNormal = FVector::ZeroVector;
+
+	/* World space movement input, used for mid air jumps and air control. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Launch)
+	FVector inputDir = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Launch)
+	bool isFalling = false;
+
+	/* The character stands on an edge and receives a jump boost. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Launch)
+	bool jumpBoost = false;
+};
+
+/* Ballistic arc resulting from a FLaunchQuery. */
+USTRUCT(BlueprintType)
+struct FLaunchArcPrediction
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = Launch)
+	FVector launchVelocity = FVector::ZeroVector;
+
+	/* Capsule centers along the arc, the last point is the landing position when hit is set. */
+	UPROPERTY(BlueprintReadOnly, Category = Launch)
+	TArray<FVector> points;
+
+	UPROPERTY(BlueprintReadOnly, Category = Launch)
+	bool hit = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = Launch)
+	FHitResult landingHit;
+
+	/* Time in seconds until the hit or the end of the prediction. */
+	UPROPERTY(BlueprintReadOnly, Category = Launch)
+	float airTime = 0.0f;
 };
 
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
@@ -46,6 +223,32 @@ public:
 	UFUNCTION()
 	void Slide();
 
+	/* Store a pressed action. It is performed as soon as it is possible within its buffer window. */
+	void bufferAction(EBufferedAction action);
+
+	/* Query describing the current state of the character. The cached jump boost edge estimate is used when checkJumpBoost is set. */
+	UFUNCTION(BlueprintCallable, Category = Launch)
+	FLaunchQuery makeLaunchQuery(bool checkJumpBoost = true) const;
+
+	/* Launch velocity the character would receive when jumping in the state of the query. */
+	UFUNCTION(BlueprintPure, Category = Launch)
+	FVector predictLaunchVelocity(FLaunchQuery const & query) const;
+
+	/*
+	 * Predict the arcs of many launches at once without touching the character. Runs the queries in parallel,
+	 * each one integrates gravity and air control and sweeps the capsule along its arc until something is hit.
+	 * The arc is swept in chords sized by how far the arc bends away from them, with the capsule inflated by that distance.
+	 * Only a chord that hits is refined step by step. At most 256 steps per arc.
+	 */
+	UFUNCTION(BlueprintCallable, Category = Launch)
+	void predictLaunchArcs(TArray<FLaunchQuery> const & queries, TArray<FLaunchArcPrediction>& outArcs, float maxTime = 2.0f, float timeStep = 0.05f) const;
+
+	/*
+	 * Future positions relative to the character at the ascending times, for motion matching. Follows the wallrun with the current
+	 * curvature of the wall, brakes slides, integrates launch arcs with air control and turns toward the input on the ground. Game thread only.
+	 */
+	void predictTrajectory(float const* times, int32 numTimes, FVector* outOffsets) const;
+
 	float mRightAxis;
 	float mForwardAxis;
 
@@ -55,13 +258,17 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
 	int mRegainJumpsAfterWalljump = 1;
 
-	/* Correct the camera while performing special moves. This needs the SpringArmComponent to be set in the Init function. */
+	/* Correct the camera while performing special moves, applied by UParkourCameraModifier. This needs the SpringArmComponent to be set in the Init function. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
 	bool mCorrectCamera = true;
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Status)
 	ESpecialMovementState mState;
 
+	/* Check the transition table if the current state can be left for newState. */
+	UFUNCTION(BlueprintPure, Category = Status)
+	bool canSwitchState(ESpecialMovementState newState) const;
+
 	/** Maximum inner angle to keep wallrunning, in degrees. Range 45.0f to 180.0f */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (ClampMin = "45.0", ClampMax = "180.0", UIMin = "45.0", UIMax = "180.0"))
 	float mMaxWallrunInnerAngle = 70.0f;
@@ -85,6 +292,38 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (ClampMin = "0.0", ClampMax = "5.0", UIMin = "0.0", UIMax = "5.0"))
 	float mSlideForceMultiplier = 0.75f;
 
+	/** Seconds a jump press is kept until the jump becomes possible, e.g. pressed just before landing. Range 0.0f to 0.5f */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (ClampMin = "0.0", ClampMax = "0.5", UIMin = "0.0", UIMax = "0.5"))
+	float mJumpBufferTime = 0.15f;
+
+	/** Seconds a slide press is kept until the slide becomes possible. Range 0.0f to 0.5f */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (ClampMin = "0.0", ClampMax = "0.5", UIMin = "0.0", UIMax = "0.5"))
+	float mSlideBufferTime = 0.15f;
+
+	/** Seconds after walking off an edge or falling off a wall in which a ground jump or walljump is still possible. Range 0.0f to 0.5f */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (ClampMin = "0.0", ClampMax = "0.5", UIMin = "0.0", UIMax = "0.5"))
+	float mCoyoteTime = 0.1f;
+
+	/** Multiplier to the wallrun speed over the time on the wall. Baked into a lookup table by bakeProfiles. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Profiles)
+	class UCurveFloat* mWallrunSpeedCurve = nullptr;
+
+	/** Multiplier to mWallrunGravity over the time on the wall. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Profiles)
+	class UCurveFloat* mWallrunGravityCurve = nullptr;
+
+	/** Blend from the entry to the target vertical velocity while clawing into the wall, 0.0 to 1.0 over the claw duration. Without it the velocity eases out quadratically. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Profiles)
+	class UCurveFloat* mWallClawCurve = nullptr;
+
+	/** Multiplier to mSlideDeceleration over the slide time. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Profiles)
+	class UCurveFloat* mSlideDecelerationCurve = nullptr;
+
+	/** Bake the profile curves into their lookup tables. Done on BeginPlay, call it again after changing a curve at runtime. */
+	UFUNCTION(BlueprintCallable, Category = Profiles)
+	void bakeProfiles();
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Debug)
 	bool mDebugWallrun = false;
 
@@ -94,12 +333,6 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Debug)
 	bool mDebugSlide = false;
 
-private:
-	class ACharacter* owner;
-	class UCharacterMovementComponent* move;
-	class USpringArmComponent* cameraStick;
-	class UCameraComponent* camera;
-
 	enum EWallrunEndReason
 	{
 		USER_JUMP,		/* user jumped off */
@@ -109,6 +342,32 @@ private:
 		ANGLE_OUT_OF_BOUNDS	/* angle to keep wallrunning was exceeded */
 	};
 
+	/* Wallrun direction along a wall for the given wallrun state. */
+	static FVector calcWallrunDir(FVector wallNormal, ESpecialMovementState state);
+
+	bool surfaceIsWallrunPossible(FVector surfaceNormal) const;
+
+	/** Normal of the wall that is currently wallrun on. Only valid while wallrunning. */
+	FORCEINLINE FVector getWallNormal() const { return mWallNormal; }
+
+	FORCEINLINE FSpecialMovementAnimSnapshot const & getAnimSnapshot() const { return mAnimSnapshot; }
+
+	/* Leave every special move and restore the default movement settings, used when a pooled character is reused. */
+	void resetState();
+
+	/* Checkpoints: store the runtime state, restore it after the character was moved back. Pending input is dropped on restore. */
+	void captureSnapshot(FSpecialMovementSnapshot& outSnapshot) const;
+	void restoreSnapshot(FSpecialMovementSnapshot const & snapshot);
+
+	/* Low detail for insignificant characters: no debug output. The tick interval is reduced by the owner, see AlostandfoundCharacter::applySignificance. */
+	void setLowDetail(bool lowDetail);
+
+private:
+	class ACharacter* owner;
+	class UCharacterMovementComponent* move;
+	class USpringArmComponent* cameraStick;
+	class UCameraComponent* camera;
+
 	float mDefaultGravityScale;
 	float mDefaultAirControl;
 	float mDefaultMaxWalkSpeed;
@@ -117,18 +376,83 @@ private:
 	float mDefaultBrakingDecelerationWalking;
 	float mDefaultMaxWalkSpeedCrouched;
 
+	bool mDefaultCameraCollisionTest = true;
+
+	// ignores the owner, shared by every trace of the component
+	FCollisionQueryParams mQueryParams;
+
 	FVector mWallrunDir;
 	FVector mWallNormal;
 	FVector mWallImpact;
 	float mWallrunSpeed;
+	// yaw change of the wallrun direction in radians per second
+	float mWallrunTurnRate = 0.0f;
 
 	bool mClawIntoWall;
+	float mClawZStartVelo;
 	float mClawZTargetVelo;
 	float mClawSpeed;
 	float mClawTime;
 
 	bool mJumpMidAirAllowed = false;
 
+	// pressed actions with their world time, consumed in order as soon as they are possible
+	struct FBufferedInput
+	{
+		float time;
+		EBufferedAction action;
+	};
+	static constexpr int32 InputBufferSize = 8;
+	FBufferedInput mInputBuffer[InputBufferSize];
+	int32 mInputBufferStart = 0;
+	int32 mInputBufferCount = 0;
+	void processInputBuffer();
+	bool tryJump();
+
+	// coyote time: world time the character last stood on the ground or left a wall without jumping
+	float mLastGroundTime = -1.0f;
+	float mLastWallTime = -1.0f;
+	ESpecialMovementState mLastWallState = ESpecialMovementState::NONE;
+	FVector mLastWallNormal = FVector::ZeroVector;
+
+	// jump boost edge estimate, kept up to date from the floor of the character movement so a jump needs no query
+	TWeakObjectPtr<class UPrimitiveComponent> mEdgeFloor;
+	FBox mEdgeFloorLocalBox = FBox(ForceInit);
+	FVector mEdgeProbeLocation = FVector::ZeroVector;
+	bool mEdgeProbeValid = false;
+	bool mOnJumpBoostEdge = false;
+	void updateEdgeEstimate();
+	// distance to the border of the floor along dir, 0.0 when the floor collision is not a single box
+	float calcFloorExitDistance(class UPrimitiveComponent* floor, FVector const & location, FVector const & dir);
+	// local collision box of a box component or a static mesh with a single box element, invalid for every other shape
+	static FBox calcFloorCollisionBox(class UPrimitiveComponent const* floor);
+	bool probeJumpBoostEdge(FVector const & probeOrigin) const;
+	void resetEdgeEstimate();
+
+	// telemetry: world time the current state was entered and walljumps since the last landing
+	float mStateEnterTime = 0.0f;
+	int32 mWalljumpChain = 0;
+	float getStateTime() const;
+
+	// profile lookup tables, sampled with the simulated time in the current state
+	FCurveLUT mWallrunSpeedLUT;
+	FCurveLUT mWallrunGravityLUT;
+	FCurveLUT mWallClawLUT;
+	FCurveLUT mSlideDecelerationLUT;
+	float mProfileTime = 0.0f;
+
+	FSpecialMovementAnimSnapshot mAnimSnapshot;
+	void refreshAnimSnapshot();
+
+	bool mLowDetail = false;
+#if UE_BUILD_SHIPPING
+	// compiles the debug draws and message formatting out of the hot path
+	FORCEINLINE bool isDebugging(bool debugFlag) const { return false; }
+#else
+	FORCEINLINE bool isDebugging(bool debugFlag) const { return debugFlag && mLowDetail == false; }
+#endif
+	void updateSpecialMoves(float time);
+
 	bool mWallrunPrevention = false;
 	FTimerHandle mWallrunPreventTimer;
 	UFUNCTION()
@@ -139,10 +463,9 @@ private:
 
 	ESpecialMovementState findWallrunSide(FVector wallNormal);
 	bool checkDirectionForWall(FHitResult& hit, FVector const & origin, FVector direction);
-	FVector calcWallrunDir(FVector wallNormal, ESpecialMovementState state);
-	FVector calcLaunchVelocity(bool jumpBoostEnabled = true) const;
+	FVector calcLaunchVelocity(FLaunchQuery const & query) const;
+	FORCEINLINE bool isOnJumpBoostEdge() const { return mOnJumpBoostEdge; }
 
-	bool surfaceIsWallrunPossible(FVector surfaceNormal) const;
 	bool isWallrunInputPressed() const;
 
 	void clampHorizontalVelocity(FVector & velocity, float const maxSpeed) const;
@@ -154,18 +477,29 @@ private:
 	bool isWallrunning(bool considerUp = false) const;
 	void startWallrun(const FHitResult& wallHit);
 	void endWallrun(EWallrunEndReason endReason);
+	void onWalljump();
 	void updateWallrun(float time);
 
 	double calcAngleBetweenVectors(FVector a, FVector b);
-	bool isValidInnerOuterAngleDiff(FVector const & origin, const FHitResult& hit, double * angleOut = NULL);
-	void addCameraRotation(FRotator const & addRotation);
+	bool isValidInnerOuterAngleDiff(FVector const & origin, FVector const & impactPoint, FVector const & impactNormal);
 
 	bool canJumpBoost() const;
 
 	bool canSlide();
-	void startSlide();
+	bool startSlide();
 	void endSlide(EWallrunEndReason endReason);
 	void updateSlide(float time);
 
 	bool switchState(ESpecialMovementState newState);
+
+	// enter/exit hooks per state, called by switchState. nullptr when a state has no side effects.
+	typedef void (USpecialMovementComponent::*StateHookFn)();
+	struct FStateHooks
+	{
+		StateHookFn onEnter;
+		StateHookFn onExit;
+	};
+	static const FStateHooks StateHooks[SpecialMovementTransitions::NumStates];
+
+	void exitSlide();
 };
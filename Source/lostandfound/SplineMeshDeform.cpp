@@ -4,12 +4,14 @@
 #include "SplineMeshDeform.h"
 #include "Runtime/Engine/Classes/Components/SplineComponent.h"
 #include "Runtime/Engine/Classes/Components/SplineMeshComponent.h"
+#include "ParkourMemory.h"
 
 // Sets default values
 ASplineMeshDeform::ASplineMeshDeform()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	//PrimaryActorTick.bCanEverTick = true;
+	// only ticks while runtime segments are built
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 
 	m_spline = CreateDefaultSubobject<USplineComponent>(TEXT("Spline"));
 	RootComponent = m_spline;
@@ -17,81 +19,174 @@ ASplineMeshDeform::ASplineMeshDeform()
 }
 
 void ASplineMeshDeform::constructSplineMeshes() {
-	if (m_spline->GetNumberOfSplinePoints() > 1 && m_splineMesh)
+	LLM_SCOPE_BYTAG(Parkour);
+
+	TArray<USceneComponent*> a;
+	m_spline->GetChildrenComponents(false, a);
+	for (USceneComponent* segment : a)
 	{
-		TArray<USceneComponent*> a;
-		m_spline->GetChildrenComponents(false, a);
-		for (USceneComponent* segment : a)
-		{
-			// only destroy it when it is a splinemeshcomponent
-			if (segment->IsA<USplineMeshComponent>())
-				segment->DestroyComponent();
-		}
+		// only destroy it when it is a splinemeshcomponent
+		if (segment->IsA<USplineMeshComponent>())
+			segment->DestroyComponent();
+	}
+	mSegments.Reset();
+	mSegmentPool.Reset();
+
+	scheduleBuild(0);
+#if !UE_BUILD_SHIPPING
+	if (isBuilding()) {
+		GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Red, FString::Printf(TEXT("SplineMeshLength %f"), mSegmentLength));
+	}
+#endif
+
+	// the construction script builds everything at once
+	while (isBuilding()) {
+		buildSegment(mNextSegment++);
+	}
+	SetActorTickEnabled(false);
+}
+
+void ASplineMeshDeform::setPoints(TArray<FVector> const & points, ESplineCoordinateSpace::Type space)
+{
+	LLM_SCOPE_BYTAG(Parkour);
+	m_spline->SetSplinePoints(points, space);
+	scheduleBuild(0);
+}
 
-		ESplineCoordinateSpace::Type space = ESplineCoordinateSpace::Local;
+void ASplineMeshDeform::addPoint(FVector const & point, ESplineCoordinateSpace::Type space)
+{
+	LLM_SCOPE_BYTAG(Parkour);
+	m_spline->AddSplinePoint(point, space);
+
+	// the new point changes the tangent of the previous one, rebuild from the point before it
+	int32 const numPoints = m_spline->GetNumberOfSplinePoints();
+	float const rebuildDistance = numPoints > 2 ? m_spline->GetDistanceAlongSplineAtSplinePoint(numPoints - 3) : 0.0f;
+	scheduleBuild(mSegmentLength > 0.0f ? FMath::FloorToInt(rebuildDistance / mSegmentLength) : 0);
+}
 
+void ASplineMeshDeform::scheduleBuild(int32 firstSegment)
+{
+	mNumSegments = 0;
+	mSegmentLength = 0.0f;
+
+	if (m_spline->GetNumberOfSplinePoints() > 1 && m_splineMesh)
+	{
 		// try to get "length" of staticMesh used:
 		FBox bb = m_splineMesh->GetBoundingBox();
-		FVector axisLengths = bb.Max - bb.Min;
-		//axisLengths *= GetActorScale();
+		mMeshSize = bb.Max - bb.Min;
 
-		float fSplineMeshLength = axisLengths.X;
+		float fSplineMeshLength = mMeshSize.X;
 		if (mLengthAxis == EAxis::Type::Y) {
-			fSplineMeshLength = axisLengths.Y;
+			fSplineMeshLength = mMeshSize.Y;
 		}
 		else if (mLengthAxis == EAxis::Type::Z) {
-			fSplineMeshLength = axisLengths.Z;
+			fSplineMeshLength = mMeshSize.Z;
+		}
+		mSegmentLength = FMath::Abs(fSplineMeshLength);
+
+		if (mSegmentLength > KINDA_SMALL_NUMBER) {
+			// the last segment reaches over the end of the spline
+			mNumSegments = FMath::CeilToInt(m_spline->GetSplineLength() / mSegmentLength);
 		}
+	}
+
+	while (mSegments.Num() > mNumSegments) {
+		releaseSegment(mSegments.Pop());
+	}
 
-		fSplineMeshLength = FMath::Abs(fSplineMeshLength);
+	// segments that get a new shape lose their collision until they are built again
+	mNextSegment = FMath::Clamp(firstSegment, 0, mSegments.Num());
+	for (int32 i = mNextSegment; i < mSegments.Num(); i++) {
+		mSegments[i]->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	}
 
-		GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Red, FString::Printf(TEXT("SplineMeshLength %f"), fSplineMeshLength));
-		float splineLen = m_spline->GetSplineLength();
-		for (float currentDistance = 0.0; currentDistance < m_spline->GetSplineLength(); currentDistance += fSplineMeshLength)
-		{
-			// create UsplineMeshComponent
-			USplineMeshComponent* segmentMesh = NewObject<USplineMeshComponent>(this);
+	SetActorTickEnabled(isBuilding());
+}
 
-			segmentMesh->SetStaticMesh(m_splineMesh);
-			//segmentMesh->SetRelativeScale3D(GetActorScale());
-			segmentMesh->SetStartScale(FVector2D(mMeshScale_Y, mMeshScale_Z));
-			segmentMesh->SetEndScale(FVector2D(mMeshScale_Y, mMeshScale_Z));
+void ASplineMeshDeform::buildSegment(int32 index)
+{
+	if (index >= mSegments.Num()) {
+		mSegments.Add(acquireSegment());
+	}
+	USplineMeshComponent* segmentMesh = mSegments[index];
 
-			segmentMesh->SetMobility(EComponentMobility::Movable);
-			segmentMesh->AttachToComponent(m_spline, FAttachmentTransformRules::KeepRelativeTransform);
-			segmentMesh->RegisterComponent();
+	ESplineCoordinateSpace::Type space = ESplineCoordinateSpace::Local;
 
-			FVector start, end, start_tangent, end_tangent;
-			float endDist = currentDistance + fSplineMeshLength;
-			// clamp at the end
-			//float endDist = FMath::Min(currentDistance + fSplineMeshLength, m_spline->GetSplineLength());
+	segmentMesh->SetStaticMesh(m_splineMesh);
+	segmentMesh->SetStartScale(FVector2D(mMeshScale_Y, mMeshScale_Z), false);
+	segmentMesh->SetEndScale(FVector2D(mMeshScale_Y, mMeshScale_Z), false);
 
-			start = m_spline->GetLocationAtDistanceAlongSpline(currentDistance, space);
-			start_tangent = m_spline->GetTangentAtDistanceAlongSpline(currentDistance, space);
+	FVector start, end, start_tangent, end_tangent;
+	float const currentDistance = index * mSegmentLength;
+	float const endDist = currentDistance + mSegmentLength;
 
-			end = m_spline->GetLocationAtDistanceAlongSpline(endDist, space);
-			end_tangent = m_spline->GetTangentAtDistanceAlongSpline(endDist, space);
+	start = m_spline->GetLocationAtDistanceAlongSpline(currentDistance, space);
+	start_tangent = m_spline->GetTangentAtDistanceAlongSpline(currentDistance, space);
 
-			if (mSplineAtTop) {
-				start.Z -= axisLengths.Z * mMeshScale_Z;
-				end.Z -= axisLengths.Z * mMeshScale_Z;
-			}
+	end = m_spline->GetLocationAtDistanceAlongSpline(endDist, space);
+	end_tangent = m_spline->GetTangentAtDistanceAlongSpline(endDist, space);
 
-			segmentMesh->SetStartAndEnd(start, start_tangent, end, end_tangent);
+	if (mSplineAtTop) {
+		start.Z -= mMeshSize.Z * mMeshScale_Z;
+		end.Z -= mMeshSize.Z * mMeshScale_Z;
+	}
 
-			segmentMesh->SetCollisionEnabled(mCollisionEnabled);
-			segmentMesh->SetCollisionObjectType(mCollisionChannel);
-			// TODO include?
-			//segmentMesh->SetCollisionProfileName("");
-			//segmentMesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Block);
-		}
+	segmentMesh->SetStartAndEnd(start, start_tangent, end, end_tangent);
+	segmentMesh->SetVisibility(true);
+
+	// the segment is complete, now it can collide
+	segmentMesh->SetCollisionObjectType(mCollisionChannel);
+	segmentMesh->SetCollisionEnabled(mCollisionEnabled);
+}
+
+USplineMeshComponent* ASplineMeshDeform::acquireSegment()
+{
+	if (mSegmentPool.Num() > 0) {
+		return mSegmentPool.Pop();
 	}
+	return createSegment();
+}
+
+USplineMeshComponent* ASplineMeshDeform::createSegment()
+{
+	// create UsplineMeshComponent, hidden and without collision until it is built
+	USplineMeshComponent* segmentMesh = NewObject<USplineMeshComponent>(this);
+	segmentMesh->SetMobility(EComponentMobility::Movable);
+	segmentMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	segmentMesh->SetVisibility(false);
+	segmentMesh->AttachToComponent(m_spline, FAttachmentTransformRules::KeepRelativeTransform);
+	segmentMesh->RegisterComponent();
+	return segmentMesh;
+}
+
+void ASplineMeshDeform::releaseSegment(USplineMeshComponent* segment)
+{
+	segment->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	segment->SetVisibility(false);
+	mSegmentPool.Add(segment);
 }
 
 // Called when the game starts or when spawned
 void ASplineMeshDeform::BeginPlay()
 {
 	Super::BeginPlay();
+	LLM_SCOPE_BYTAG(Parkour);
+
+	// take over the segments built by the construction script
+	TArray<USceneComponent*> children;
+	m_spline->GetChildrenComponents(false, children);
+	mSegments.Reset();
+	for (USceneComponent* child : children) {
+		if (USplineMeshComponent* segment = Cast<USplineMeshComponent>(child)) {
+			mSegments.Add(segment);
+		}
+	}
+	scheduleBuild(mSegments.Num());
+
+	// pre-warm the pool so runtime building does not create components
+	while (mSegmentPool.Num() < mPrewarmSegments) {
+		mSegmentPool.Add(createSegment());
+	}
 }
 
 void ASplineMeshDeform::OnConstruction(const FTransform& Transform)
@@ -103,6 +198,19 @@ void ASplineMeshDeform::OnConstruction(const FTransform& Transform)
 void ASplineMeshDeform::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
+	LLM_SCOPE_BYTAG(Parkour);
+
+	// time sliced runtime building
+	double const endTime = FPlatformTime::Seconds() + mBuildBudgetMs * 0.001;
+	while (isBuilding()) {
+		buildSegment(mNextSegment++);
+		if (FPlatformTime::Seconds() >= endTime) {
+			break;
+		}
+	}
 
+	if (isBuilding() == false) {
+		SetActorTickEnabled(false);
+		mOnBuilt.Broadcast();
+	}
 }
-
@@ -4,12 +4,20 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "Components/SplineComponent.h"
 #include "UObject/NoExportTypes.h"
 
 #include "SplineMeshDeform.generated.h"
 
 class USplineMeshComponent;
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnSplineMeshesBuilt);
+
+/*
+ * Deforms a static mesh along a spline. In the editor the meshes are built by the construction script,
+ * at runtime setPoints and addPoint rebuild them over several frames within mBuildBudgetMs.
+ * Runtime segments come from a pool of spline mesh components, a segment only gets collision once it is built.
+ */
 UCLASS()
 class LOSTANDFOUND_API ASplineMeshDeform : public AActor
 {
@@ -43,6 +51,29 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
 	bool mSplineAtTop = false;
 
+	/* Spline mesh components created on BeginPlay for runtime building. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Runtime, meta = (ClampMin = "0", UIMin = "0"))
+	int32 mPrewarmSegments = 16;
+
+	/* Time per frame spent on building segments at runtime, in milliseconds. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Runtime, meta = (ClampMin = "0.05", UIMin = "0.05"))
+	float mBuildBudgetMs = 1.0f;
+
+	/* Called when all segments of a runtime build are done. */
+	UPROPERTY(BlueprintAssignable, Category = Runtime)
+	FOnSplineMeshesBuilt mOnBuilt;
+
+	/* Replace all spline points and rebuild the meshes over the next frames. */
+	UFUNCTION(BlueprintCallable, Category = Runtime)
+	void setPoints(TArray<FVector> const & points, ESplineCoordinateSpace::Type space = ESplineCoordinateSpace::World);
+
+	/* Append a spline point, only the segments from the previous point on are rebuilt. */
+	UFUNCTION(BlueprintCallable, Category = Runtime)
+	void addPoint(FVector const & point, ESplineCoordinateSpace::Type space = ESplineCoordinateSpace::World);
+
+	UFUNCTION(BlueprintPure, Category = Runtime)
+	bool isBuilding() const { return mNextSegment < mNumSegments; }
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
@@ -56,4 +87,23 @@ public:
 private:
 
 	void constructSplineMeshes();
+
+	UPROPERTY(Transient)
+	TArray<USplineMeshComponent*> mSegments;
+
+	UPROPERTY(Transient)
+	TArray<USplineMeshComponent*> mSegmentPool;
+
+	int32 mNextSegment = 0;
+	int32 mNumSegments = 0;
+	float mSegmentLength = 0.0f;
+	FVector mMeshSize = FVector::ZeroVector;
+
+	USplineMeshComponent* createSegment();
+	USplineMeshComponent* acquireSegment();
+	void releaseSegment(USplineMeshComponent* segment);
+
+	/* Start building from firstSegment on, segments before it keep their shape. */
+	void scheduleBuild(int32 firstSegment);
+	void buildSegment(int32 index);
 };
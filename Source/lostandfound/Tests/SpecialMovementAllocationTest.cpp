@@ -0,0 +1,161 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+
+// the counting allocator can only be installed in monolithic builds, see ParkourMemory.h
+#if WITH_DEV_AUTOMATION_TESTS && IS_MONOLITHIC && !UE_BUILD_SHIPPING
+
+#include "lostandfoundCharacter.h"
+#include "SpecialMovementComponent.h"
+#include "ParkourInputScript.h"
+#include "ParkourMemory.h"
+#include "AIController.h"
+#include "Components/BoxComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+
+namespace ParkourAllocationTest
+{
+	// a fixed step keeps the scripted sequence deterministic
+	constexpr float TimeStep = 0.01f;
+
+	struct FRunResult
+	{
+		bool wallrun = false;
+		bool walljump = false;
+		bool slide = false;
+	};
+
+	static void spawnBlock(UWorld* world, FVector const & center, FVector const & extent)
+	{
+		AActor* block = world->SpawnActor<AActor>(AActor::StaticClass(), FTransform(center));
+		UBoxComponent* box = NewObject<UBoxComponent>(block);
+		box->SetBoxExtent(extent, false);
+		box->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+		block->SetRootComponent(box);
+		box->SetWorldLocation(center);
+		box->RegisterComponent();
+	}
+
+	static FRunResult runSequence(UWorld* world, AlostandfoundCharacter* character, FParkourInputScript& script, int32 frames)
+	{
+		FRunResult result;
+		bool wasWallrunning = false;
+
+		for (int32 frame = 0; frame < frames; frame++) {
+			script.tick(TimeStep, character);
+			world->Tick(LEVELTICK_All, TimeStep);
+
+			ESpecialMovementState const state = character->GetSpecialMoves()->getAnimSnapshot().state;
+			bool const wallrunning = state == ESpecialMovementState::WALLRUN_LEFT || state == ESpecialMovementState::WALLRUN_RIGHT;
+
+			result.wallrun |= wallrunning;
+			// the wall is on the right, a walljump pushes off towards -Y
+			result.walljump |= wasWallrunning && wallrunning == false && character->GetVelocity().Y < 0.0f;
+			result.slide |= state == ESpecialMovementState::SLIDE;
+			wasWallrunning = wallrunning;
+		}
+		return result;
+	}
+}
+
+/*
+ * Runs a scripted wallrun, walljump and slide twice in a bare world: the first run warms up everything that grows once,
+ * the second counts every heap allocation on the game thread while the character is ticked.
+ *
+ * Needs the counting allocator, see ParkourMemory.h: a monolithic build started with PARKOUR_ALLOCATION_CHECK=1, otherwise it is skipped. E.g.
+ * PARKOUR_ALLOCATION_CHECK=1 lostandfound -nullrhi -ExecCmds="Automation RunTests lostandfound.SpecialMovement;Quit"
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSpecialMovementAllocationTest, "lostandfound.SpecialMovement.AllocationFree",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FSpecialMovementAllocationTest::RunTest(const FString& Parameters)
+{
+	using namespace ParkourAllocationTest;
+
+	if (ParkourAllocationCheck::isInstalled() == false) {
+		AddWarning(TEXT("Skipped, the counting allocator is only installed with PARKOUR_ALLOCATION_CHECK=1 set."));
+		return true;
+	}
+
+	UWorld* world = UWorld::CreateWorld(EWorldType::Game, false, TEXT("ParkourAllocationTest"));
+	FWorldContext& context = GEngine->CreateNewWorldContext(EWorldType::Game);
+	context.SetCurrentWorld(world);
+	world->InitializeActorsForPlay(FURL());
+	world->BeginPlay();
+	// there is no game mode to start the match, begin play on the actors like the sweep commandlet does
+	world->GetWorldSettings()->NotifyBeginPlay();
+
+	// a floor and a wall on the right of the running line, the face of the wall at y = 120
+	spawnBlock(world, FVector(0.0f, 0.0f, -50.0f), FVector(5000.0f, 5000.0f, 50.0f));
+	spawnBlock(world, FVector(1500.0f, 170.0f, 500.0f), FVector(1500.0f, 50.0f, 500.0f));
+
+	FActorSpawnParameters spawnParams;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	AlostandfoundCharacter* character = world->SpawnActor<AlostandfoundCharacter>(AlostandfoundCharacter::StaticClass(), FVector(0.0f, 0.0f, 100.0f), FRotator::ZeroRotator, spawnParams);
+	if (character) {
+		character->SpawnDefaultController();
+	}
+
+	AAIController* ai = character ? Cast<AAIController>(character->GetController()) : nullptr;
+	if (ai == nullptr) {
+		AddError(TEXT("Could not spawn a controlled character."));
+		GEngine->DestroyWorldContext(world);
+		world->DestroyWorld(false);
+		return false;
+	}
+
+	// the script steers relative to the control rotation, keep it fixed along +X
+	ai->bSetControlRotationFromPawnOrientation = false;
+	ai->SetControlRotation(FRotator::ZeroRotator);
+
+	// land on the floor before taking the start checkpoint
+	for (int32 frame = 0; frame < 50; frame++) {
+		world->Tick(LEVELTICK_All, TimeStep);
+	}
+
+	FParkourCheckpoint start;
+	character->captureCheckpoint(start);
+
+	// {duration, forward, right, jump, slide, turnYaw}
+	TArray<FParkourInputScript::FStep> steps = {
+		{ 0.4f, 1.0f, 0.0f, false, false, 0.0f },	// run along the wall
+		{ 0.1f, 1.0f, 1.0f, true, false, 0.0f },	// jump towards it
+		{ 0.8f, 1.0f, 1.0f, false, false, 0.0f },	// hit it while falling and wallrun
+		{ 0.1f, 1.0f, 0.0f, true, false, 0.0f },	// walljump
+		{ 1.2f, 1.0f, 0.0f, false, false, 0.0f },	// land and get back to full speed
+		{ 0.8f, 1.0f, 0.0f, false, true, 0.0f },	// slide
+	};
+
+	float duration = 0.0f;
+	for (FParkourInputScript::FStep const & step : steps) {
+		duration += step.duration;
+	}
+	int32 const frames = FMath::RoundToInt(duration / TimeStep);
+
+	FParkourInputScript script = FParkourInputScript::makeFromSteps(MoveTemp(steps));
+
+	// the first run sizes the pools, timers and query caches that only grow once
+	runSequence(world, character, script, frames);
+
+	character->restoreCheckpoint(start);
+	script.restart();
+
+	ParkourAllocationCheck::arm(true);
+	FRunResult const result = runSequence(world, character, script, frames);
+	uint64 const allocations = ParkourAllocationCheck::getAllocations();
+	ParkourAllocationCheck::arm(false);
+
+	TestTrue(TEXT("Wallrun started"), result.wallrun);
+	TestTrue(TEXT("Jumped off the wall"), result.walljump);
+	TestTrue(TEXT("Slide started"), result.slide);
+	TestEqual(TEXT("Allocations while armed"), (int64)allocations, (int64)0);
+
+	GEngine->DestroyWorldContext(world);
+	world->DestroyWorld(false);
+	return true;
+}
+
+#endif
@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "TrajectoryRecorder.h"
+
+/*
+ * Encodes a run with delta records, forced keyframes and a jump too far for a delta, decodes the file again
+ * and compares every sample within the quantization steps.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrajectoryCodecRoundTripTest, "lostandfound.TrajectoryCodec.RoundTrip",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTrajectoryCodecRoundTripTest::RunTest(const FString& Parameters)
+{
+	using namespace TrajectoryCodec;
+
+	// more samples than a keyframe interval, so keyframes are forced in between
+	constexpr int32 NumSamples = KeyframeInterval * 2 + 17;
+	constexpr int32 TeleportSample = 150;
+
+	TArray<FTrajectorySample> samples;
+	for (int32 i = 0; i < NumSamples; i++) {
+		FTrajectorySample& sample = samples.AddDefaulted_GetRef();
+		sample.time = i / 60.0f;
+		sample.position = FVector(i * 12.34f, -i * 5.67f, 100.0f + FMath::Sin(i * 0.1f) * 50.0f);
+		if (i >= TeleportSample) {
+			// further than a 16 bit delta reaches
+			sample.position.X += 50000.0f;
+		}
+		sample.velocity = FVector(740.0f, -340.0f, i % 2 ? 420.0f : -980.0f);
+		sample.controlRotation = FRotator(-20.0f, i * 3.0f - 180.0f, 0.0f);
+		sample.state = (ESpecialMovementState)(i % (int32)ESpecialMovementState::MAX);
+		sample.wallNormal = FVector(0.6f, -0.8f, 0.0f);
+	}
+
+	TArray<uint8> data;
+	uint32 const magic = FileMagic;
+	uint16 const version = FileVersion;
+	data.Append((uint8 const*)&magic, sizeof(magic));
+	data.Append((uint8 const*)&version, sizeof(version));
+
+	FEncoderState encoder;
+	int32 keyframes = 0;
+	for (FTrajectorySample const & sample : samples) {
+		uint8 record[MaxRecordSize];
+		int32 const size = encode(encoder, sample, record);
+		if (size != DeltaRecordSize && size != KeyframeRecordSize) {
+			AddError(FString::Printf(TEXT("Record of %d bytes, expected %d or %d."), size, DeltaRecordSize, KeyframeRecordSize));
+			return false;
+		}
+		keyframes += size == KeyframeRecordSize;
+		data.Append(record, size);
+	}
+
+	// the first sample, the one forced after a keyframe interval and the teleport
+	TestEqual(TEXT("Keyframes"), keyframes, 3);
+
+	TArray<FTrajectorySample> decoded;
+	if (TestTrue(TEXT("Decoded"), decodeFile(data, decoded)) == false) {
+		return false;
+	}
+	if (TestEqual(TEXT("Sample count"), decoded.Num(), NumSamples) == false) {
+		return false;
+	}
+	TestTrue(TEXT("Sample count estimate is an upper bound"), decoded.Max() >= NumSamples);
+
+	float const rotationStep = 360.0f / 65536.0f;
+	for (int32 i = 0; i < NumSamples; i++) {
+		FTrajectorySample const & expected = samples[i];
+		FTrajectorySample const & actual = decoded[i];
+		FString const what = FString::Printf(TEXT("Sample %d"), i);
+
+		// the encoder keeps the quantized time and position, errors do not accumulate
+		TestEqual(*(what + TEXT(" time")), actual.time, expected.time, TimeUnit);
+		TestEqual(*(what + TEXT(" position")), actual.position, expected.position, PositionUnit);
+		TestEqual(*(what + TEXT(" velocity")), actual.velocity, expected.velocity, 0.5f);
+		TestEqual(*(what + TEXT(" yaw")), FRotator::NormalizeAxis(actual.controlRotation.Yaw - expected.controlRotation.Yaw), 0.0f, rotationStep);
+		TestEqual(*(what + TEXT(" pitch")), FRotator::NormalizeAxis(actual.controlRotation.Pitch - expected.controlRotation.Pitch), 0.0f, rotationStep);
+		TestEqual(*(what + TEXT(" state")), (int32)actual.state, (int32)expected.state);
+		TestEqual(*(what + TEXT(" wall normal")), actual.wallNormal, expected.wallNormal, 1.0f / 127.0f);
+	}
+
+	// a cut off record is invalid data, not a shorter run
+	data.SetNum(data.Num() - 1);
+	TestFalse(TEXT("Truncated file is rejected"), decodeFile(data, decoded));
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "TrajectoryGhost.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Misc/FileHelper.h"
+
+ATrajectoryGhost::ATrajectoryGhost()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	// recorded positions are capsule centers, the root stands in for the capsule
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+	mMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("Mesh"));
+	mMesh->SetupAttachment(RootComponent);
+	mMesh->SetRelativeLocationAndRotation(FVector(0.0f, 0.0f, -96.0f), FRotator(0.0f, -90.0f, 0.0f));
+	mMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	mMesh->SetGenerateOverlapEvents(false);
+	mMesh->CastShadow = false;
+}
+
+void ATrajectoryGhost::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (mAutoPlayRecording.IsEmpty() == false && loadRecording(mAutoPlayRecording)) {
+		startPlayback();
+	}
+}
+
+bool ATrajectoryGhost::loadRecording(FString const & name)
+{
+	stopPlayback();
+
+	TArray<uint8> data;
+	if (FFileHelper::LoadFileToArray(data, *UTrajectoryRecorderComponent::getRecordingPath(name)) == false) {
+		return false;
+	}
+
+	if (TrajectoryCodec::decodeFile(data, mSamples) == false) {
+		mSamples.Reset();
+		return false;
+	}
+
+	return mSamples.Num() > 0;
+}
+
+void ATrajectoryGhost::startPlayback()
+{
+	if (mSamples.Num() == 0) {
+		return;
+	}
+
+	mPlaybackTime = mSamples[0].time;
+	mCursor = 0;
+	SetActorTickEnabled(true);
+}
+
+void ATrajectoryGhost::stopPlayback()
+{
+	SetActorTickEnabled(false);
+}
+
+void ATrajectoryGhost::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	mPlaybackTime += DeltaTime;
+
+	// samples are sorted by time, advance the cursor instead of searching
+	int32 const last = mSamples.Num() - 1;
+	while (mCursor < last && mSamples[mCursor + 1].time <= mPlaybackTime) {
+		mCursor++;
+	}
+
+	if (mCursor >= last) {
+		mCurrentSample = mSamples[last];
+		if (mLoop) {
+			startPlayback();
+		}
+		else {
+			stopPlayback();
+		}
+	}
+	else {
+		FTrajectorySample const & a = mSamples[mCursor];
+		FTrajectorySample const & b = mSamples[mCursor + 1];
+		float const alpha = FMath::Clamp((mPlaybackTime - a.time) / FMath::Max(b.time - a.time, KINDA_SMALL_NUMBER), 0.0f, 1.0f);
+
+		mCurrentSample.time = mPlaybackTime;
+		mCurrentSample.position = FMath::Lerp(a.position, b.position, alpha);
+		mCurrentSample.velocity = FMath::Lerp(a.velocity, b.velocity, alpha);
+		mCurrentSample.controlRotation = FMath::Lerp(a.controlRotation, b.controlRotation, alpha);
+		mCurrentSample.state = alpha < 0.5f ? a.state : b.state;
+		mCurrentSample.wallNormal = FMath::Lerp(a.wallNormal, b.wallNormal, alpha);
+	}
+
+	// face the movement direction like the character does with bOrientRotationToMovement
+	FRotator rotation = GetActorRotation();
+	if (FVector2D(mCurrentSample.velocity).SizeSquared() > 1.0f) {
+		rotation = FRotator(0.0f, mCurrentSample.velocity.Rotation().Yaw, 0.0f);
+	}
+	SetActorLocationAndRotation(mCurrentSample.position, rotation);
+}
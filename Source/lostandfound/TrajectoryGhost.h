@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "TrajectoryRecorder.h"
+#include "TrajectoryGhost.generated.h"
+
+/*
+ * Lightweight ghost that replays a recorded run by interpolating between samples.
+ * No movement component and no collision, the special movement state is only mirrored for animation.
+ */
+UCLASS()
+class LOSTANDFOUND_API ATrajectoryGhost : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ATrajectoryGhost();
+
+	virtual void Tick(float DeltaTime) override;
+
+	/* Load Saved/Ghosts/<name>.lfghost, see UTrajectoryRecorderComponent. */
+	UFUNCTION(BlueprintCallable, Category = Trajectory)
+	bool loadRecording(FString const & name);
+
+	UFUNCTION(BlueprintCallable, Category = Trajectory)
+	void startPlayback();
+
+	UFUNCTION(BlueprintCallable, Category = Trajectory)
+	void stopPlayback();
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Mesh)
+	class USkeletalMeshComponent* mMesh;
+
+	/* Recording to load and play on BeginPlay, leave empty to start manually. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
+	FString mAutoPlayRecording;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
+	bool mLoop = false;
+
+	/* Interpolated sample of the current playback time, for animation blueprints. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Status)
+	FTrajectorySample mCurrentSample;
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+	TArray<FTrajectorySample> mSamples;
+	float mPlaybackTime;
+	int32 mCursor;
+};
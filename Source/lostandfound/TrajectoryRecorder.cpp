@@ -0,0 +1,316 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "TrajectoryRecorder.h"
+#include "Async/Async.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/Controller.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+namespace TrajectoryCodec
+{
+	template<typename T>
+	static void write(uint8*& out, T const value)
+	{
+		FMemory::Memcpy(out, &value, sizeof(T));
+		out += sizeof(T);
+	}
+
+	template<typename T>
+	static bool read(uint8 const*& in, uint8 const* end, T& value)
+	{
+		if (in + sizeof(T) > end) {
+			return false;
+		}
+		FMemory::Memcpy(&value, in, sizeof(T));
+		in += sizeof(T);
+		return true;
+	}
+
+	static int16 toInt16(float value)
+	{
+		return (int16)FMath::Clamp(FMath::RoundToInt(value), (int32)MIN_int16, (int32)MAX_int16);
+	}
+
+	static int8 toNormalByte(float value)
+	{
+		return (int8)FMath::Clamp(FMath::RoundToInt(value * 127.0f), -127, 127);
+	}
+
+	int32 encode(FEncoderState& encoder, FTrajectorySample const & sample, uint8* out)
+	{
+		uint8* const start = out;
+
+		FIntVector const position(FMath::RoundToInt(sample.position.X / PositionUnit), FMath::RoundToInt(sample.position.Y / PositionUnit), FMath::RoundToInt(sample.position.Z / PositionUnit));
+		FIntVector const delta = position - encoder.lastPosition;
+		bool const deltaFits = FMath::Abs(delta.X) <= MAX_int16 && FMath::Abs(delta.Y) <= MAX_int16 && FMath::Abs(delta.Z) <= MAX_int16;
+		bool const keyframe = deltaFits == false || encoder.samplesSinceKeyframe >= KeyframeInterval;
+
+		uint16 const timeDelta = (uint16)FMath::Clamp(FMath::RoundToInt((sample.time - encoder.lastTime) / TimeUnit), 0, (int32)MAX_uint16);
+
+		write<uint8>(out, keyframe ? KEYFRAME : 0);
+		write<uint8>(out, (uint8)sample.state);
+		write<uint16>(out, timeDelta);
+
+		if (keyframe) {
+			write<int32>(out, position.X);
+			write<int32>(out, position.Y);
+			write<int32>(out, position.Z);
+			encoder.samplesSinceKeyframe = 0;
+		}
+		else {
+			write<int16>(out, (int16)delta.X);
+			write<int16>(out, (int16)delta.Y);
+			write<int16>(out, (int16)delta.Z);
+			encoder.samplesSinceKeyframe++;
+		}
+
+		write<int16>(out, toInt16(sample.velocity.X));
+		write<int16>(out, toInt16(sample.velocity.Y));
+		write<int16>(out, toInt16(sample.velocity.Z));
+
+		write<uint16>(out, FRotator::CompressAxisToShort(sample.controlRotation.Yaw));
+		write<uint16>(out, FRotator::CompressAxisToShort(sample.controlRotation.Pitch));
+
+		write<int8>(out, toNormalByte(sample.wallNormal.X));
+		write<int8>(out, toNormalByte(sample.wallNormal.Y));
+		write<int8>(out, toNormalByte(sample.wallNormal.Z));
+
+		// keep the quantized values to avoid drift between encoder and decoder
+		encoder.lastPosition = position;
+		encoder.lastTime += timeDelta * TimeUnit;
+
+		check(out - start <= MaxRecordSize);
+		return out - start;
+	}
+
+	bool decodeFile(TArray<uint8> const & data, TArray<FTrajectorySample>& outSamples)
+	{
+		uint8 const* in = data.GetData();
+		uint8 const* const end = in + data.Num();
+
+		uint32 magic = 0;
+		uint16 version = 0;
+		if (read(in, end, magic) == false || read(in, end, version) == false || magic != FileMagic || version != FileVersion) {
+			return false;
+		}
+
+		// delta records are the common and the smallest case, an upper bound of the sample count
+		outSamples.Reset((end - in) / DeltaRecordSize);
+
+		FIntVector position = FIntVector::ZeroValue;
+		float time = 0.0f;
+		while (in < end) {
+			uint8 flags, state;
+			uint16 timeDelta, yaw, pitch;
+			int16 vx, vy, vz;
+			int8 nx, ny, nz;
+
+			if (read(in, end, flags) == false || read(in, end, state) == false || read(in, end, timeDelta) == false) {
+				return false;
+			}
+
+			if (flags & KEYFRAME) {
+				if (read(in, end, position.X) == false || read(in, end, position.Y) == false || read(in, end, position.Z) == false) {
+					return false;
+				}
+			}
+			else {
+				int16 dx, dy, dz;
+				if (read(in, end, dx) == false || read(in, end, dy) == false || read(in, end, dz) == false) {
+					return false;
+				}
+				position += FIntVector(dx, dy, dz);
+			}
+
+			if (read(in, end, vx) == false || read(in, end, vy) == false || read(in, end, vz) == false ||
+				read(in, end, yaw) == false || read(in, end, pitch) == false ||
+				read(in, end, nx) == false || read(in, end, ny) == false || read(in, end, nz) == false) {
+				return false;
+			}
+
+			time += timeDelta * TimeUnit;
+
+			FTrajectorySample& sample = outSamples.AddDefaulted_GetRef();
+			sample.time = time;
+			sample.position = FVector(position) * PositionUnit;
+			sample.velocity = FVector(vx, vy, vz);
+			sample.controlRotation = FRotator(FRotator::DecompressAxisFromShort(pitch), FRotator::DecompressAxisFromShort(yaw), 0.0f);
+			sample.state = state < (uint8)ESpecialMovementState::MAX ? (ESpecialMovementState)state : ESpecialMovementState::NONE;
+			sample.wallNormal = FVector(nx, ny, nz) / 127.0f;
+		}
+
+		return true;
+	}
+}
+
+UTrajectoryRecorderComponent::UTrajectoryRecorderComponent()
+	: mWriteCount(0)
+	, mReadCount(0)
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	// record the final position of the frame
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+}
+
+void UTrajectoryRecorderComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	owner = Cast<ACharacter>(GetOwner());
+	specialMoves = GetOwner()->FindComponentByClass<USpecialMovementComponent>();
+}
+
+void UTrajectoryRecorderComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	stopRecording();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+FString UTrajectoryRecorderComponent::getRecordingPath(FString const & name)
+{
+	return FPaths::ProjectSavedDir() / TEXT("Ghosts") / name + TEXT(".lfghost");
+}
+
+bool UTrajectoryRecorderComponent::startRecording(FString const & name)
+{
+	stopRecording();
+
+	if (owner == nullptr) {
+		return false;
+	}
+
+	mFile.Reset(IFileManager::Get().CreateFileWriter(*getRecordingPath(name)));
+	if (mFile.IsValid() == false) {
+		return false;
+	}
+
+	uint32 magic = TrajectoryCodec::FileMagic;
+	uint16 version = TrajectoryCodec::FileVersion;
+	*mFile << magic;
+	*mFile << version;
+
+	uint32 const size = FMath::RoundUpToPowerOfTwo(FMath::Max(mBufferSize, 1024));
+	mRing.SetNumUninitialized(size);
+	mRingMask = size - 1;
+	mFlushScratch.Reset(size);
+	mWriteCount = 0;
+	mReadCount = 0;
+	mDroppedSamples = 0;
+
+	mEncoder = TrajectoryCodec::FEncoderState();
+	mRecordingTime = 0.0f;
+
+	SetComponentTickEnabled(true);
+	return true;
+}
+
+void UTrajectoryRecorderComponent::stopRecording()
+{
+	if (isRecording() == false) {
+		return;
+	}
+
+	SetComponentTickEnabled(false);
+
+	waitForFlush();
+	flushRing();
+
+	mFile->Close();
+	mFile.Reset();
+}
+
+void UTrajectoryRecorderComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	mRecordingTime += DeltaTime;
+
+	FTrajectorySample sample;
+	sample.time = mRecordingTime;
+	sample.position = owner->GetActorLocation();
+	sample.velocity = owner->GetVelocity();
+	if (AController* controller = owner->GetController()) {
+		sample.controlRotation = controller->GetControlRotation();
+	}
+	if (specialMoves) {
+		sample.state = specialMoves->mState;
+		sample.wallNormal = specialMoves->getWallNormal();
+	}
+
+	pushSample(sample);
+}
+
+void UTrajectoryRecorderComponent::pushSample(FTrajectorySample const & sample)
+{
+	uint32 const write = mWriteCount.load(std::memory_order_relaxed);
+	uint32 const read = mReadCount.load(std::memory_order_acquire);
+	uint32 const capacity = mRingMask + 1;
+
+	if (capacity - (write - read) < TrajectoryCodec::MaxRecordSize) {
+		// the flush task does not keep up, drop the sample instead of blocking the game thread.
+		// the next encoded record is a keyframe so playback only interpolates over the gap.
+		mDroppedSamples++;
+		mEncoder.samplesSinceKeyframe = TrajectoryCodec::KeyframeInterval;
+		kickFlush();
+		return;
+	}
+
+	uint8 record[TrajectoryCodec::MaxRecordSize];
+	int32 const size = TrajectoryCodec::encode(mEncoder, sample, record);
+
+	uint32 const offset = write & mRingMask;
+	uint32 const firstPart = FMath::Min<uint32>(size, capacity - offset);
+	FMemory::Memcpy(mRing.GetData() + offset, record, firstPart);
+	if (firstPart < (uint32)size) {
+		FMemory::Memcpy(mRing.GetData(), record + firstPart, size - firstPart);
+	}
+	mWriteCount.store(write + size, std::memory_order_release);
+
+	if (write + size - read >= capacity * mFlushThreshold) {
+		kickFlush();
+	}
+}
+
+void UTrajectoryRecorderComponent::kickFlush()
+{
+	if (mFlushTask.IsValid() && mFlushTask.IsReady() == false) {
+		return;
+	}
+
+	mFlushTask = Async(EAsyncExecution::ThreadPool, [this]() { flushRing(); });
+}
+
+void UTrajectoryRecorderComponent::waitForFlush()
+{
+	if (mFlushTask.IsValid()) {
+		mFlushTask.Wait();
+		mFlushTask.Reset();
+	}
+}
+
+void UTrajectoryRecorderComponent::flushRing()
+{
+	// runs on a worker thread or on the game thread after waitForFlush, never concurrently
+	uint32 const read = mReadCount.load(std::memory_order_relaxed);
+	uint32 const write = mWriteCount.load(std::memory_order_acquire);
+	uint32 const size = write - read;
+	if (size == 0) {
+		return;
+	}
+
+	uint32 const capacity = mRingMask + 1;
+	uint32 const offset = read & mRingMask;
+	uint32 const firstPart = FMath::Min(size, capacity - offset);
+
+	mFlushScratch.SetNumUninitialized(size, false);
+	FMemory::Memcpy(mFlushScratch.GetData(), mRing.GetData() + offset, firstPart);
+	if (firstPart < size) {
+		FMemory::Memcpy(mFlushScratch.GetData() + firstPart, mRing.GetData(), size - firstPart);
+	}
+	mReadCount.store(write, std::memory_order_release);
+
+	mFile->Serialize(mFlushScratch.GetData(), size);
+}
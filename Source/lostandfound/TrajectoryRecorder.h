@@ -0,0 +1,138 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Async/Future.h"
+#include "SpecialMovementComponent.h"
+#include <atomic>
+#include "TrajectoryRecorder.generated.h"
+
+/* One decoded sample of a recorded run. */
+USTRUCT(BlueprintType)
+struct FTrajectorySample
+{
+	GENERATED_BODY()
+
+	/* seconds since the recording started */
+	UPROPERTY(BlueprintReadOnly, Category = Trajectory)
+	float time = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = Trajectory)
+	FVector position = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = Trajectory)
+	FVector velocity = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = Trajectory)
+	FRotator controlRotation = FRotator::ZeroRotator;
+
+	UPROPERTY(BlueprintReadOnly, Category = Trajectory)
+	ESpecialMovementState state = ESpecialMovementState::NONE;
+
+	UPROPERTY(BlueprintReadOnly, Category = Trajectory)
+	FVector wallNormal = FVector::ZeroVector;
+};
+
+/*
+ * Quantization and delta compression of trajectory samples.
+ * A record is: flags, state, time delta, position (absolute on keyframes, delta otherwise), velocity, yaw/pitch, wall normal.
+ */
+namespace TrajectoryCodec
+{
+	constexpr uint32 FileMagic = 0x5254464C; // "LFTR"
+	constexpr uint16 FileVersion = 1;
+
+	constexpr float PositionUnit = 0.1f;	// cm per quantization step
+	constexpr float TimeUnit = 0.0001f;		// seconds per quantization step
+	constexpr int32 KeyframeInterval = 100;	// force an absolute position at least every N samples
+	constexpr int32 DeltaRecordSize = 23;		// 16 bit position delta
+	constexpr int32 KeyframeRecordSize = 29;	// 32 bit absolute position
+	constexpr int32 MaxRecordSize = 32;
+	static_assert(DeltaRecordSize <= KeyframeRecordSize && KeyframeRecordSize <= MaxRecordSize, "records have to fit into MaxRecordSize");
+
+	enum ERecordFlags : uint8
+	{
+		KEYFRAME = 1 << 0
+	};
+
+	struct FEncoderState
+	{
+		FIntVector lastPosition = FIntVector::ZeroValue;
+		float lastTime = 0.0f;
+		int32 samplesSinceKeyframe = KeyframeInterval;
+	};
+
+	// writes the record for sample into out and returns the number of bytes written (<= MaxRecordSize)
+	int32 encode(FEncoderState& encoder, FTrajectorySample const & sample, uint8* out);
+
+	// decodes a whole recording file (including header), returns false on invalid data
+	bool decodeFile(TArray<uint8> const & data, TArray<FTrajectorySample>& outSamples);
+}
+
+/*
+ * Records the owning character's run into a lock-free single producer / single consumer ring buffer.
+ * The game thread only quantizes and copies a record per tick, a background task streams the ring buffer to disk.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class LOSTANDFOUND_API UTrajectoryRecorderComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UTrajectoryRecorderComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/* Start a new recording to Saved/Ghosts/<name>.lfghost, an already running recording is stopped first. */
+	UFUNCTION(BlueprintCallable, Category = Trajectory)
+	bool startRecording(FString const & name);
+
+	/* Stop recording and write all remaining samples to disk. */
+	UFUNCTION(BlueprintCallable, Category = Trajectory)
+	void stopRecording();
+
+	UFUNCTION(BlueprintPure, Category = Trajectory)
+	bool isRecording() const { return mFile.IsValid(); }
+
+	static FString getRecordingPath(FString const & name);
+
+	/* Size of the ring buffer in bytes, rounded up to a power of two. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (ClampMin = "1024", UIMin = "1024"))
+	int32 mBufferSize = 64 * 1024;
+
+	/* Kick off a background flush when the ring buffer is filled by this fraction. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (ClampMin = "0.1", ClampMax = "0.9", UIMin = "0.1", UIMax = "0.9"))
+	float mFlushThreshold = 0.25f;
+
+	/* Number of samples dropped because the ring buffer was full. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Status)
+	int32 mDroppedSamples = 0;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	class ACharacter* owner;
+	class USpecialMovementComponent* specialMoves;
+
+	TArray<uint8> mRing;
+	uint32 mRingMask = 0;
+	// mWriteCount is only advanced by the game thread, mReadCount only by the flush task
+	std::atomic<uint32> mWriteCount;
+	std::atomic<uint32> mReadCount;
+
+	TUniquePtr<FArchive> mFile;
+	TArray<uint8> mFlushScratch;
+	TFuture<void> mFlushTask;
+
+	TrajectoryCodec::FEncoderState mEncoder;
+	float mRecordingTime;
+
+	void pushSample(FTrajectorySample const & sample);
+	void kickFlush();
+	void waitForFlush();
+	void flushRing();
+};
@@ -8,6 +8,12 @@ public class lostandfound : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay" });
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay", "NavigationSystem", "AIModule", "SignificanceManager", "RenderCore", "RHI", "EnhancedInput", "ReplicationGraph" });
+
+		// offline retarget bake in UParkourRetargetCommandlet
+		if (Target.bBuildEditor)
+		{
+			PrivateDependencyModuleNames.AddRange(new string[] { "UnrealEd", "AssetRegistry", "IKRig", "IKRigEditor" });
+		}
 	}
 }
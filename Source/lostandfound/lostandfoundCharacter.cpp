@@ -4,10 +4,23 @@
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
+#include "EnhancedInputComponent.h"
+#include "EnhancedInputSubsystems.h"
+#include "Engine/LocalPlayer.h"
+#include "InputMappingContext.h"
+#include "Components/SkeletalMeshComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Controller.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "SpecialMovementComponent.h"
+#include "MovementHistory.h"
+#include "ParkourStreamingSource.h"
+#include "ParkourCameraModifier.h"
+#include "ParkourSignificance.h"
+#include "ParkourCharacterPool.h"
+#include "GameFramework/GameModeBase.h"
 
 //////////////////////////////////////////////////////////////////////////
 // AlostandfoundCharacter
@@ -51,6 +64,11 @@ AlostandfoundCharacter::AlostandfoundCharacter()
 	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
 
 	specialMoves = CreateDefaultSubobject<USpecialMovementComponent>(TEXT("specialMoves"));
+	movementHistory = CreateDefaultSubobject<UMovementHistoryComponent>(TEXT("movementHistory"));
+	streamingSource = CreateDefaultSubobject<UParkourStreamingSourceComponent>(TEXT("streamingSource"));
+
+	// skip animation frames based on screen size, see applySignificance for the distance based buckets
+	GetMesh()->bEnableUpdateRateOptimizations = true;
 
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named ThirdPersonCharacter (to avoid direct content references in C++)
@@ -63,8 +81,19 @@ void AlostandfoundCharacter::SetupPlayerInputComponent(class UInputComponent* Pl
 {
 	// Set up gameplay key bindings
 	check(PlayerInputComponent);
-	PlayerInputComponent->BindAction("Jump", IE_Pressed, this, &AlostandfoundCharacter::Jump);
-	PlayerInputComponent->BindAction("Jump", IE_Released, this, &AlostandfoundCharacter::StopJumping);
+
+	// jump and slide presses are buffered by the special moves, see USpecialMovementComponent::bufferAction
+	UEnhancedInputComponent* enhancedInput = Cast<UEnhancedInputComponent>(PlayerInputComponent);
+	if (enhancedInput && ParkourMappingContext && JumpAction && SlideAction) {
+		enhancedInput->BindAction(JumpAction, ETriggerEvent::Started, this, &AlostandfoundCharacter::Jump);
+		enhancedInput->BindAction(JumpAction, ETriggerEvent::Completed, this, &AlostandfoundCharacter::StopJumping);
+		enhancedInput->BindAction(SlideAction, ETriggerEvent::Started, this->specialMoves, &USpecialMovementComponent::Slide);
+	}
+	else {
+		PlayerInputComponent->BindAction("Jump", IE_Pressed, this, &AlostandfoundCharacter::Jump);
+		PlayerInputComponent->BindAction("Jump", IE_Released, this, &AlostandfoundCharacter::StopJumping);
+		PlayerInputComponent->BindAction("SpecialMove1", IE_Pressed, this->specialMoves, &USpecialMovementComponent::Slide);
+	}
 
 	PlayerInputComponent->BindAxis("Move Forward / Backward", this, &AlostandfoundCharacter::MoveForward);
 	PlayerInputComponent->BindAxis("Move Right / Left", this, &AlostandfoundCharacter::MoveRight);
@@ -77,13 +106,31 @@ void AlostandfoundCharacter::SetupPlayerInputComponent(class UInputComponent* Pl
 	PlayerInputComponent->BindAxis("Look Up / Down Mouse", this, &APawn::AddControllerPitchInput);
 	PlayerInputComponent->BindAxis("Look Up / Down Gamepad", this, &AlostandfoundCharacter::LookUpAtRate);
 
-	PlayerInputComponent->BindAction("SpecialMove1", IE_Pressed, this->specialMoves, &USpecialMovementComponent::Slide);
-
 	// handle touch devices
 	PlayerInputComponent->BindTouch(IE_Pressed, this, &AlostandfoundCharacter::TouchStarted);
 	PlayerInputComponent->BindTouch(IE_Released, this, &AlostandfoundCharacter::TouchStopped);
 }
 
+void AlostandfoundCharacter::PawnClientRestart()
+{
+	Super::PawnClientRestart();
+
+	APlayerController* playerController = Cast<APlayerController>(GetController());
+	if (playerController == nullptr) {
+		return;
+	}
+
+	APlayerCameraManager* cameraManager = playerController->PlayerCameraManager;
+	if (cameraManager && cameraManager->FindCameraModifierByClass(UParkourCameraModifier::StaticClass()) == nullptr) {
+		cameraManager->AddNewCameraModifier(UParkourCameraModifier::StaticClass());
+	}
+
+	UEnhancedInputLocalPlayerSubsystem* subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(playerController->GetLocalPlayer());
+	if (subsystem && ParkourMappingContext) {
+		subsystem->AddMappingContext(ParkourMappingContext, 0);
+	}
+}
+
 void AlostandfoundCharacter::Jump()
 {
 	specialMoves->Jump();
@@ -127,6 +174,169 @@ void AlostandfoundCharacter::BeginPlay()
 
 	GetCapsuleComponent()->OnComponentHit.AddDynamic(this, &AlostandfoundCharacter::OnPlayerHit);
 	specialMoves->Init(this, FollowCamera, CameraBoom);
+
+	// animation reads the special movement snapshot, make sure it is refreshed before the mesh ticks
+	GetMesh()->AddTickPrerequisiteComponent(specialMoves);
+
+	if (UParkourSignificanceSubsystem* significance = GetWorld()->GetSubsystem<UParkourSignificanceSubsystem>()) {
+		significance->registerCharacter(this);
+	}
+}
+
+void AlostandfoundCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UParkourSignificanceSubsystem* significance = GetWorld()->GetSubsystem<UParkourSignificanceSubsystem>()) {
+		significance->unregisterCharacter(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AlostandfoundCharacter::FellOutOfWorld(const UDamageType& dmgType)
+{
+	UParkourCharacterPoolSubsystem* pool = GetWorld()->GetSubsystem<UParkourCharacterPoolSubsystem>();
+	if (HasAuthority() == false || pool == nullptr) {
+		Super::FellOutOfWorld(dmgType);
+		return;
+	}
+
+	// back to the pool instead of destroyed, a player respawns with a pooled character through the game mode
+	APlayerController* playerController = Cast<APlayerController>(GetController());
+	pool->release(this);
+
+	AGameModeBase* gameMode = GetWorld()->GetAuthGameMode();
+	if (playerController && gameMode && gameMode->PlayerCanRestart(playerController)) {
+		gameMode->RestartPlayer(playerController);
+	}
+}
+
+void AlostandfoundCharacter::applySignificance(EParkourSignificance significance)
+{
+	// tick interval per bucket: CULLED, LOW, MEDIUM, HIGH
+	static const float tickIntervals[] = { 0.25f, 0.1f, 1.0f / 30.0f, 0.0f };
+	static const EVisibilityBasedAnimTickOption animTickOptions[] = {
+		EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered,
+		EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered,
+		EVisibilityBasedAnimTickOption::AlwaysTickPose,
+		EVisibilityBasedAnimTickOption::AlwaysTickPose
+	};
+
+	uint8 const bucket = (uint8)significance;
+	// the character movement keeps its full rate: simulated proxies smooth the mesh toward the replicated position in its tick,
+	// and on a server it is the simulation itself. Only animation is throttled everywhere.
+	SetActorTickInterval(tickIntervals[bucket]);
+	GetMesh()->SetComponentTickInterval(tickIntervals[bucket]);
+
+	// the special moves are simulation as well (wall following, claw, profiles) on the server and the owning client,
+	// only simulated proxies follow the replicated state and can run them at a lower rate
+	bool const simulated = GetLocalRole() == ROLE_SimulatedProxy;
+	specialMoves->SetComponentTickInterval(simulated ? tickIntervals[bucket] : 0.0f);
+	specialMoves->setLowDetail(significance < EParkourSignificance::HIGH);
+	GetMesh()->VisibilityBasedAnimTickOption = animTickOptions[bucket];
+
+	// nobody looks through the camera of far away characters, skip the spring arm probe
+	CameraBoom->SetComponentTickEnabled(significance == EParkourSignificance::HIGH);
+}
+
+void AlostandfoundCharacter::resetState()
+{
+	specialMoves->resetState();
+	movementHistory->resetHistory();
+
+	UnCrouch();
+	StopJumping();
+	ResetJumpState();
+
+	UCharacterMovementComponent* move = GetCharacterMovement();
+	move->StopMovementImmediately();
+	move->ClearAccumulatedForces();
+	move->SetMovementMode(move->DefaultLandMovementMode);
+
+	// full rate tick intervals, detail and camera boom tick, the significance manager applies the real bucket once registered again
+	applySignificance(EParkourSignificance::HIGH);
+
+	// the checkpoint belongs to the previous user of a pooled character
+	mCheckpoint = FParkourCheckpoint();
+}
+
+void AlostandfoundCharacter::captureCheckpoint(FParkourCheckpoint& outCheckpoint) const
+{
+	UCharacterMovementComponent const * move = GetCharacterMovement();
+
+	outCheckpoint.valid = true;
+	outCheckpoint.location = GetActorLocation();
+	outCheckpoint.rotation = GetActorQuat();
+	outCheckpoint.velocity = move->Velocity;
+	outCheckpoint.controlRotation = Controller ? Controller->GetControlRotation() : GetActorRotation();
+	outCheckpoint.movementMode = move->MovementMode;
+	outCheckpoint.customMovementMode = move->CustomMovementMode;
+	outCheckpoint.jumpCurrentCount = JumpCurrentCount;
+	outCheckpoint.crouched = bIsCrouched;
+	specialMoves->captureSnapshot(outCheckpoint.specialMoves);
+}
+
+void AlostandfoundCharacter::restoreCheckpoint(FParkourCheckpoint const & checkpoint)
+{
+	if (checkpoint.valid == false) {
+		return;
+	}
+
+	UCharacterMovementComponent* move = GetCharacterMovement();
+	StopJumping();
+	move->StopMovementImmediately();
+	move->ClearAccumulatedForces();
+
+	SetActorLocationAndRotation(checkpoint.location, checkpoint.rotation, false, nullptr, ETeleportType::TeleportPhysics);
+	if (Controller) {
+		Controller->SetControlRotation(checkpoint.controlRotation);
+	}
+
+	// entering walking looks for the floor at the new location, force it when the mode does not change
+	if (move->MovementMode == checkpoint.movementMode && move->IsMovingOnGround()) {
+		move->FindFloor(move->UpdatedComponent->GetComponentLocation(), move->CurrentFloor, false);
+	}
+	move->SetMovementMode(checkpoint.movementMode, checkpoint.customMovementMode);
+	move->Velocity = checkpoint.velocity;
+
+	JumpCurrentCount = checkpoint.jumpCurrentCount;
+	if (checkpoint.crouched && bIsCrouched == false) {
+		Crouch();
+	}
+	else if (checkpoint.crouched == false && bIsCrouched) {
+		UnCrouch();
+	}
+
+	specialMoves->restoreSnapshot(checkpoint.specialMoves);
+	// the teleport is not a real movement, rewinding across it would be wrong
+	movementHistory->resetHistory();
+}
+
+void AlostandfoundCharacter::saveCheckpoint()
+{
+	captureCheckpoint(mCheckpoint);
+}
+
+bool AlostandfoundCharacter::loadCheckpoint()
+{
+	if (mCheckpoint.valid == false) {
+		return false;
+	}
+
+	restoreCheckpoint(mCheckpoint);
+	return true;
+}
+
+void AlostandfoundCharacter::applyBotInput(float forward, float right, bool jump, bool slide)
+{
+	MoveForward(forward);
+	MoveRight(right);
+
+	if (jump) {
+		Jump();
+	}
+	if (slide) {
+		specialMoves->Slide();
+	}
 }
 
 void AlostandfoundCharacter::TurnAtRate(float Rate)
@@ -4,8 +4,26 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "SpecialMovementComponent.h"
 #include "lostandfoundCharacter.generated.h"
 
+enum class EParkourSignificance : uint8;
+
+/* Everything needed to put a character back to a checkpoint, see AlostandfoundCharacter::captureCheckpoint. Plain data, restoring does not allocate. */
+struct FParkourCheckpoint
+{
+	bool valid = false;
+	FVector location;
+	FQuat rotation;
+	FVector velocity;
+	FRotator controlRotation;
+	TEnumAsByte<EMovementMode> movementMode;
+	uint8 customMovementMode;
+	int32 jumpCurrentCount;
+	bool crouched;
+	FSpecialMovementSnapshot specialMoves;
+};
+
 UCLASS(config=Game)
 class AlostandfoundCharacter : public ACharacter
 {
@@ -21,6 +39,14 @@ class AlostandfoundCharacter : public ACharacter
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Movement, meta = (AllowPrivateAccess = "true"))
 	class USpecialMovementComponent* specialMoves;
+
+	/** Server side movement history for lag compensation */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Movement, meta = (AllowPrivateAccess = "true"))
+	class UMovementHistoryComponent* movementHistory;
+
+	/** Streams World Partition cells in along the predicted trajectory */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Streaming, meta = (AllowPrivateAccess = "true"))
+	class UParkourStreamingSourceComponent* streamingSource;
 public:
 	AlostandfoundCharacter();
 
@@ -28,6 +54,16 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Input)
 	float TurnRateGamepad;
 
+	/** Enhanced Input context with JumpAction and SlideAction. Without it the Jump and SpecialMove1 action mappings are used. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Input)
+	class UInputMappingContext* ParkourMappingContext;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Input)
+	class UInputAction* JumpAction;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Input)
+	class UInputAction* SlideAction;
+
 protected:
 
 	/** Called for forwards/backward input */
@@ -58,10 +94,13 @@ protected:
 	void Tick(float time);
 
 	void BeginPlay();
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void FellOutOfWorld(const class UDamageType& dmgType) override;
 
 protected:
 	// APawn interface
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
+	virtual void PawnClientRestart() override;
 	// End of APawn interface
 
 	void Jump() override;
@@ -71,9 +110,37 @@ protected:
 	void OnPlayerHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComponent, FVector NormalImpulse, const FHitResult& Hit);
 
 public:
+	/** Reduce tick rates, special movement detail and animation for far away or hidden characters. Called by UParkourSignificanceSubsystem. */
+	void applySignificance(EParkourSignificance significance);
+
+	/** Reset movement, special moves, history, significance settings and the saved checkpoint to a freshly spawned state. Used by UParkourCharacterPoolSubsystem instead of destroy and spawn. */
+	void resetState();
+
+	/** Store the complete movement state, restoreCheckpoint puts the character back within a single frame. */
+	void captureCheckpoint(FParkourCheckpoint& outCheckpoint) const;
+	void restoreCheckpoint(FParkourCheckpoint const & checkpoint);
+
+	/** Capture a checkpoint into the slot of the character, e.g. from a checkpoint trigger. */
+	UFUNCTION(BlueprintCallable, Category = Checkpoint)
+	void saveCheckpoint();
+
+	/** Retry from the last saved checkpoint. Returns false when none was saved. */
+	UFUNCTION(BlueprintCallable, Category = Checkpoint)
+	bool loadCheckpoint();
+
+	/** Drive the character through the regular input handlers, used by the bot client mode. */
+	void applyBotInput(float forward, float right, bool jump, bool slide);
+
 	/** Returns CameraBoom subobject **/
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
 	/** Returns FollowCamera subobject **/
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
+	/** Returns specialMoves subobject **/
+	FORCEINLINE class USpecialMovementComponent* GetSpecialMoves() const { return specialMoves; }
+	/** Returns movementHistory subobject **/
+	FORCEINLINE class UMovementHistoryComponent* GetMovementHistory() const { return movementHistory; }
+
+private:
+	FParkourCheckpoint mCheckpoint;
 };
 
@@ -2,14 +2,111 @@
 
 #include "lostandfoundGameMode.h"
 #include "lostandfoundCharacter.h"
-#include "UObject/ConstructorHelpers.h"
+#include "ParkourContentAsset.h"
+#include "ParkourCharacterPool.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "GameFramework/PlayerController.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogParkourStartup, Log, All);
 
 AlostandfoundGameMode::AlostandfoundGameMode()
 {
-	// set default pawn class to our Blueprinted character
-	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnBPClass(TEXT("/Game/ThirdPerson/Blueprints/BP_ThirdPersonCharacter"));
-	if (PlayerPawnBPClass.Class != NULL)
-	{
-		DefaultPawnClass = PlayerPawnBPClass.Class;
+	// the Blueprinted character is streamed in by InitGame instead of loaded here, see loadStartupContent
+	mPlayerPawnClass = TSoftClassPtr<APawn>(FSoftObjectPath(TEXT("/Game/ThirdPerson/Blueprints/BP_ThirdPersonCharacter.BP_ThirdPersonCharacter_C")));
+	mStartupContent = FPrimaryAssetId(UParkourContentAsset::AssetType, TEXT("DA_ParkourStartup"));
+}
+
+void AlostandfoundGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	// start streaming before the level actors begin play
+	loadStartupContent();
+}
+
+void AlostandfoundGameMode::loadStartupContent()
+{
+	mLoadStartTime = FPlatformTime::Seconds();
+	UAssetManager& assetManager = UAssetManager::Get();
+	FStreamableDelegate const onLoaded = FStreamableDelegate::CreateUObject(this, &AlostandfoundGameMode::onStartupContentLoaded);
+
+	if (assetManager.GetPrimaryAssetPath(mStartupContent).IsValid()) {
+		mStartupHandle = assetManager.LoadPrimaryAsset(mStartupContent, { UParkourContentAsset::StartupBundle }, onLoaded, FStreamableManager::AsyncLoadHighPriority);
+	}
+	else {
+		UE_LOG(LogParkourStartup, Log, TEXT("no startup content %s, streaming %s only"), *mStartupContent.ToString(), *mPlayerPawnClass.ToString());
+		mStartupHandle = assetManager.GetStreamableManager().RequestAsyncLoad(mPlayerPawnClass.ToSoftObjectPath(), onLoaded, FStreamableManager::AsyncLoadHighPriority);
+	}
+
+	if (mStartupHandle.IsValid()) {
+		mStartupHandle->BindUpdateDelegate(FStreamableUpdateDelegate::CreateUObject(this, &AlostandfoundGameMode::onStartupContentProgress));
+	}
+	else {
+		// nothing to load or everything is resident already
+		onStartupContentLoaded();
+	}
+}
+
+void AlostandfoundGameMode::onStartupContentProgress(TSharedRef<FStreamableHandle> handle)
+{
+	mOnStartupContentProgress.Broadcast(handle->GetProgress());
+}
+
+void AlostandfoundGameMode::onStartupContentLoaded()
+{
+	if (mStartupContentLoaded) {
+		return;
+	}
+	mStartupContentLoaded = true;
+
+	UClass* pawnClass = nullptr;
+	if (UParkourContentAsset* content = UAssetManager::Get().GetPrimaryAssetObject<UParkourContentAsset>(mStartupContent)) {
+		pawnClass = content->mCharacterClass.Get();
+	}
+	if (pawnClass == nullptr) {
+		pawnClass = mPlayerPawnClass.Get();
+	}
+	if (pawnClass) {
+		DefaultPawnClass = pawnClass;
 	}
+	else {
+		UE_LOG(LogParkourStartup, Error, TEXT("neither %s nor %s resolved to a pawn class, players spawn as %s"),
+			*mStartupContent.ToString(), *mPlayerPawnClass.ToString(), *GetNameSafe(DefaultPawnClass));
+	}
+
+	// pool the class the players actually spawn as
+	UParkourCharacterPoolSubsystem* pool = GetWorld()->GetSubsystem<UParkourCharacterPoolSubsystem>();
+	if (pool && DefaultPawnClass && DefaultPawnClass->IsChildOf<AlostandfoundCharacter>()) {
+		pool->setDefaultClass(DefaultPawnClass.Get());
+	}
+
+	UE_LOG(LogParkourStartup, Log, TEXT("startup content resident after %.2f s"), FPlatformTime::Seconds() - mLoadStartTime);
+	mOnStartupContentProgress.Broadcast(1.0f);
+
+	// spawn the players that joined while loading
+	for (FConstPlayerControllerIterator it = GetWorld()->GetPlayerControllerIterator(); it; ++it) {
+		APlayerController* controller = it->Get();
+		if (controller && controller->GetPawn() == nullptr && PlayerCanRestart(controller)) {
+			RestartPlayer(controller);
+		}
+	}
+}
+
+bool AlostandfoundGameMode::PlayerCanRestart_Implementation(APlayerController* Player)
+{
+	// spawning is deferred until the startup content is resident
+	return mStartupContentLoaded && Super::PlayerCanRestart_Implementation(Player);
+}
+
+APawn* AlostandfoundGameMode::SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform)
+{
+	// reuse a pooled character on (re)spawn when one is available
+	UClass* pawnClass = GetDefaultPawnClassForController(NewPlayer);
+	UParkourCharacterPoolSubsystem* pool = GetWorld()->GetSubsystem<UParkourCharacterPoolSubsystem>();
+	if (pool && pawnClass && pawnClass->IsChildOf<AlostandfoundCharacter>() && pool->getNumPooled(pawnClass) > 0) {
+		return pool->acquire(pawnClass, SpawnTransform);
+	}
+
+	return Super::SpawnDefaultPawnAtTransform_Implementation(NewPlayer, SpawnTransform);
 }
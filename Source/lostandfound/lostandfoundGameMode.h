@@ -6,14 +6,47 @@
 #include "GameFramework/GameModeBase.h"
 #include "lostandfoundGameMode.generated.h"
 
-UCLASS(minimalapi)
+struct FStreamableHandle;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnStartupContentProgress, float, progress);
+
+/*
+ * Streams the startup content asynchronously while the map loads and spawns players only once it is resident.
+ * The content is the Startup bundle of mStartupContent (a UParkourContentAsset), or only mPlayerPawnClass when that asset does not exist.
+ */
+UCLASS(minimalapi, config=Game)
 class AlostandfoundGameMode : public AGameModeBase
 {
 	GENERATED_BODY()
 
 public:
 	AlostandfoundGameMode();
-};
 
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+	virtual bool PlayerCanRestart_Implementation(APlayerController* Player) override;
+	virtual APawn* SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform) override;
+
+	UPROPERTY(EditDefaultsOnly, Config, BlueprintReadOnly, Category = Startup)
+	FPrimaryAssetId mStartupContent;
 
+	/* Pawn class used when mStartupContent does not provide one. */
+	UPROPERTY(EditDefaultsOnly, Config, BlueprintReadOnly, Category = Startup)
+	TSoftClassPtr<APawn> mPlayerPawnClass;
 
+	/* Load progress from 0.0 to 1.0, 1.0 is sent once everything is resident and the players are spawned. */
+	UPROPERTY(BlueprintAssignable, Category = Startup)
+	FOnStartupContentProgress mOnStartupContentProgress;
+
+	UFUNCTION(BlueprintPure, Category = Startup)
+	bool isStartupContentLoaded() const { return mStartupContentLoaded; }
+
+private:
+	void loadStartupContent();
+	void onStartupContentProgress(TSharedRef<FStreamableHandle> handle);
+	void onStartupContentLoaded();
+
+	// keeps the startup content resident
+	TSharedPtr<FStreamableHandle> mStartupHandle;
+	bool mStartupContentLoaded = false;
+	double mLoadStartTime = 0.0;
+};